@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ *
+ * This file contains a host benchmark for the Serial Handler library. It
+ * compares the per-character decoder against the span decoder on the same
+ * stream of frames.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "serial_handler.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_CYCLE_COUNTER 1
+#endif
+
+#define FRAME_COUNT 4096
+#define ROUNDS 200
+#define CHUNK_SIZE 16  // Same as the UART receive FIFO depth
+
+static __uint8_t stream[FRAME_COUNT * 12];
+static size_t stream_length;
+static volatile unsigned int sink;
+
+static void bench_pwm_callback(__uint8_t r, __uint8_t g, __uint8_t b) {
+    sink += r + g + b;
+}
+
+static void bench_send_callback(unsigned char c) {
+    sink += c;
+}
+
+/**
+ * @brief Appends a byte to the stream, escaping it if needed.
+ */
+static void put_escaped(__uint8_t c) {
+    if (c == START_CHAR || c == END_CHAR || c == ESCAPE_CHAR) {
+        stream[stream_length++] = ESCAPE_CHAR;
+    }
+    stream[stream_length++] = c;
+}
+
+/**
+ * @brief Builds a stream of SET_LED_COLOR frames with varying payloads.
+ */
+static void build_stream(void) {
+    for (unsigned int i = 0; i < FRAME_COUNT; ++i) {
+        stream[stream_length++] = START_CHAR;
+        put_escaped(MSG_TYPE_REQUEST);
+        put_escaped(OPCODE_SET_LED_COLOR);
+        put_escaped((__uint8_t)(i * 7));
+        put_escaped((__uint8_t)(i * 13));
+        put_escaped((__uint8_t)(i * 31));
+        stream[stream_length++] = END_CHAR;
+    }
+}
+
+static uint64_t now(void) {
+#ifdef HAVE_CYCLE_COUNTER
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static uint64_t run_per_char(SerialPortHandler *handler) {
+    const uint64_t start = now();
+    for (int round = 0; round < ROUNDS; ++round) {
+        for (size_t i = 0; i < stream_length; ++i) {
+            serial_receive_char(handler, stream[i]);
+        }
+    }
+    return now() - start;
+}
+
+static uint64_t run_span(SerialPortHandler *handler) {
+    const uint64_t start = now();
+    for (int round = 0; round < ROUNDS; ++round) {
+        for (size_t i = 0; i < stream_length; i += CHUNK_SIZE) {
+            const size_t left = stream_length - i;
+            serial_receive_bytes(handler, &stream[i], left < CHUNK_SIZE ? left : CHUNK_SIZE);
+        }
+    }
+    return now() - start;
+}
+
+int main(void) {
+    SerialPortHandler handler;
+#ifdef HAVE_CYCLE_COUNTER
+    const char *unit = "cycles";
+#else
+    const char *unit = "ns";
+#endif
+
+    build_stream();
+    init_serial_port_handler(&handler, bench_pwm_callback, bench_send_callback);
+
+    // Warm up caches and branch predictors once before measuring
+    run_per_char(&handler);
+    run_span(&handler);
+
+    const double bytes = (double)stream_length * ROUNDS;
+    const uint64_t per_char = run_per_char(&handler);
+    const uint64_t span = run_span(&handler);
+
+    printf("Stream: %u frames, %zu bytes, %d rounds\n", FRAME_COUNT, stream_length, ROUNDS);
+    printf("serial_receive_char:  %.2f %s/byte\n", (double)per_char / bytes, unit);
+    printf("serial_receive_bytes: %.2f %s/byte\n", (double)span / bytes, unit);
+    return 0;
+}
@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * Temporal dithering of fractional PWM pulse widths by error diffusion.
+ */
+
+#ifndef DITHER_H
+#define DITHER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DITHER_CHANNELS 3
+#define DITHER_FRACTION_BITS 8
+
+typedef struct {
+    uint32_t base[DITHER_CHANNELS];      // Integer part of the pulse widths
+    uint8_t fraction[DITHER_CHANNELS];   // Fractional part, in 1/256
+    uint8_t error[DITHER_CHANNELS];      // Accumulated fraction not yet output
+} Dither;
+
+void dither_start(Dither *dither, const uint32_t *widths);
+void dither_step(Dither *dither, uint32_t *widths);
+bool dither_active(const Dither *dither);
+void dither_stop(Dither *dither);
+
+#endif // DITHER_H
@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * Fixed-point linear fade between two sets of PWM pulse widths, stepped once
+ * per PWM period.
+ */
+
+#ifndef FADE_H
+#define FADE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FADE_CHANNELS 3
+#define FADE_FRACTION_BITS 16
+
+typedef struct {
+    uint32_t value[FADE_CHANNELS];   // Current pulse widths, 16.16 fixed point
+    int32_t step[FADE_CHANNELS];     // Increment per step, 16.16 fixed point
+    uint32_t target[FADE_CHANNELS];  // Final pulse widths
+    volatile uint32_t steps_left;
+} Fade;
+
+void fade_start(Fade *fade, const uint32_t *from, const uint32_t *to, uint32_t steps);
+bool fade_step(Fade *fade, uint32_t *widths);
+bool fade_active(const Fade *fade);
+void fade_stop(Fade *fade);
+
+#endif // FADE_H
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * This file is part of the Serial Handler library.
+ * 
+ * Lock-free single-producer/single-consumer queue of received frames. The
+ * producer is the UART ISR and the consumer is the main loop.
+ */
+
+#ifndef FRAME_QUEUE_H
+#define FRAME_QUEUE_H
+
+#include <stddef.h>
+#include "serial_handler.h"
+
+// Number of frame slots, must be a power of two
+#ifndef FRAME_QUEUE_DEPTH
+#define FRAME_QUEUE_DEPTH 8
+#endif
+
+#if (FRAME_QUEUE_DEPTH & (FRAME_QUEUE_DEPTH - 1)) != 0
+#error "FRAME_QUEUE_DEPTH must be a power of two"
+#endif
+
+typedef struct {
+    unsigned char data[BUFFER_SIZE];
+    size_t length;
+} Frame;
+
+struct FrameQueue {
+    Frame slots[FRAME_QUEUE_DEPTH];
+    volatile unsigned int head;       // Written only by the producer
+    volatile unsigned int tail;       // Written only by the consumer
+    volatile unsigned int dropped;    // Frames lost because the queue was full
+    volatile unsigned int high_water; // Maximum number of frames queued at once
+};
+
+void frame_queue_init(FrameQueue *queue);
+int frame_queue_push(FrameQueue *queue, const unsigned char *data, size_t length);
+const Frame *frame_queue_peek(FrameQueue *queue);
+void frame_queue_release(FrameQueue *queue);
+unsigned int frame_queue_count(const FrameQueue *queue);
+
+#endif // FRAME_QUEUE_H
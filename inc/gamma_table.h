@@ -0,0 +1,17 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * Gamma correction table from 8-bit color values to PWM pulse widths. The
+ * table is generated at build time by tools/gen_gamma.c for PWM_PERIOD.
+ */
+
+#ifndef GAMMA_TABLE_H
+#define GAMMA_TABLE_H
+
+#include <stdint.h>
+
+#define GAMMA_TABLE_SIZE 256
+
+extern const uint16_t gamma_table[GAMMA_TABLE_SIZE];
+
+#endif // GAMMA_TABLE_H
@@ -6,5 +6,16 @@
 
 #ifndef LED_PWM_H
 #define LED_PWM_H
+
+// System clock presets of cpu_clock_set()
+#define CPU_CLOCK_16MHZ 0       // Internal oscillator, crystal off
+#define CPU_CLOCK_40MHZ 1
+#define CPU_CLOCK_50MHZ 2       // At start-up
+#define CPU_CLOCK_80MHZ 3
+#define CPU_CLOCK_PRESETS 4
+
+int cpu_clock_set(unsigned int preset);
 void UARTIntHandler(void);
+void SysTickIntHandler(void);
+void PendSVIntHandler(void);
 #endif // LED_PWM_H
\ No newline at end of file
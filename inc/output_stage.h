@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * Fixed-point output stage: master brightness and total duty budget.
+ */
+
+#ifndef OUTPUT_STAGE_H
+#define OUTPUT_STAGE_H
+
+#include <stdint.h>
+
+// 1.0 in the 16.16 fixed-point scales
+#define OUTPUT_STAGE_ONE 0x10000u
+
+// Budget value for no limit
+#define OUTPUT_STAGE_NO_BUDGET UINT32_MAX
+
+typedef struct {
+    uint32_t brightness;  // Master brightness, 16.16 fixed point, 0..OUTPUT_STAGE_ONE
+    uint32_t budget;      // Largest total of the scaled pulse widths
+} OutputStage;
+
+void output_stage_init(OutputStage *stage);
+void output_stage_set_brightness(OutputStage *stage, uint32_t brightness);
+void output_stage_set_budget(OutputStage *stage, uint32_t budget);
+uint32_t output_stage_scale(const OutputStage *stage, uint32_t total);
+
+#endif // OUTPUT_STAGE_H
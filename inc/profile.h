@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * Cycle-count profiling of named code regions with the DWT cycle counter.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+
+// Set to 1 to measure the regions, on the target only
+#ifndef PROFILE
+#define PROFILE 0
+#endif
+
+// DWT cycle counter of the Cortex-M4
+#define PROFILE_DWT_CTRL 0xE0001000
+#define PROFILE_DWT_CYCCNT 0xE0001004
+#define PROFILE_DWT_CTRL_CYCCNTENA 0x00000001
+#define PROFILE_DEMCR 0xE000EDFC
+#define PROFILE_DEMCR_TRCENA 0x01000000     // Enables the DWT
+
+// Profiled regions, in the order reported by GET_PROFILE
+typedef enum {
+    PROFILE_UART_ISR,           // UARTIntHandler()
+    PROFILE_RECEIVE_BYTES,      // serial_receive_bytes()
+    PROFILE_HANDLE_COMMAND,     // handle_command()
+    PROFILE_PWM_ISR,            // PWM1Gen3IntHandler()
+    PROFILE_REGIONS
+} ProfileRegionId;
+
+typedef struct {
+    uint32_t count;         // Number of measurements
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+} ProfileRegion;
+
+void profile_init(void);
+void profile_reset(void);
+void profile_record(ProfileRegionId region, uint32_t cycles);
+const ProfileRegion *profile_region(ProfileRegionId region);
+
+/**
+ * @brief Returns the DWT cycle counter.
+ */
+static inline uint32_t profile_cycles(void) {
+    return *(volatile uint32_t *)PROFILE_DWT_CYCCNT;
+}
+
+// Measure the code between PROFILE_BEGIN(start) and PROFILE_END(region, start)
+#if PROFILE
+#define PROFILE_BEGIN(start) const uint32_t start = profile_cycles()
+#define PROFILE_END(region, start) profile_record((region), profile_cycles() - (start))
+#else
+#define PROFILE_BEGIN(start) ((void)0)
+#define PROFILE_END(region, start) ((void)0)
+#endif
+
+#endif // PROFILE_H
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * This contains the function prototypes for the PWM output driver.
+ */
+
+#ifndef PWM_OUTPUT_H
+#define PWM_OUTPUT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Number of PWM channels in use, of the 16 in the channel map. Channels
+// 0..2 are the red, green and blue of the LED. By default only these are
+// used, as the other pins are not free on an unmodified LaunchPad.
+#define PWM_MAX_CHANNELS 16
+#define PWM_LED_CHANNELS 3
+#ifndef PWM_CHANNEL_COUNT
+#define PWM_CHANNEL_COUNT PWM_LED_CHANNELS
+#endif
+#if PWM_CHANNEL_COUNT < PWM_LED_CHANNELS || PWM_CHANNEL_COUNT > PWM_MAX_CHANNELS
+#error "PWM_CHANNEL_COUNT must be 3..16"
+#endif
+
+// Priority of the PWM and waveform timer interrupts, the highest that
+// CPUbasepriSet() can mask
+#define PWM_OUTPUT_INT_PRIORITY 0x20
+
+// Number of samples in the waveform table, at most the 1024 of a uDMA transfer
+#ifndef PWM_WAVEFORM_MAX_SAMPLES
+#define PWM_WAVEFORM_MAX_SAMPLES 128
+#endif
+
+void pwm_output_init(void);
+void pwm_output_set_rgb(uint32_t r, uint32_t g, uint32_t b);
+int pwm_output_set_channels(unsigned int first, const uint32_t *values, unsigned int count);
+void pwm_output_set_rgb_fine(uint32_t r, uint32_t g, uint32_t b);
+void pwm_output_fade_rgb(uint32_t r, uint32_t g, uint32_t b, uint32_t duration_ms);
+int pwm_output_waveform_set(unsigned int index, uint32_t r, uint32_t g, uint32_t b);
+int pwm_output_waveform_play(uint32_t hold_periods);
+void pwm_output_waveform_stop(void);
+int pwm_output_set_frequency(uint32_t hz);
+bool pwm_output_frequency_valid(uint32_t hz, uint32_t sysclk);
+int pwm_output_set_channel_count(unsigned int count);
+void pwm_output_set_stagger(bool enable);
+bool pwm_output_phases_pending(void);
+void pwm_output_apply_phases(void);
+void pwm_output_set_brightness(uint32_t brightness);
+void pwm_output_set_power_budget(uint32_t percent);
+uint32_t pwm_output_frequency(void);
+uint32_t pwm_output_period_count(void);
+uint32_t pwm_output_update_period(void);
+void PWM1Gen3IntHandler(void);
+void Timer0AIntHandler(void);
+void Timer1AIntHandler(void);
+void Timer2AIntHandler(void);
+
+#endif // PWM_OUTPUT_H
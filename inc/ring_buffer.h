@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * Lock-free single-producer/single-consumer byte ring buffer, used for the
+ * UART transmit path.
+ */
+
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <stddef.h>
+
+// Capacity of the ring in bytes, must be a power of two. The UART transmit
+// ring holds at least one worst-case encoded response frame.
+#ifndef RING_BUFFER_SIZE
+#define RING_BUFFER_SIZE 512
+#endif
+
+#if (RING_BUFFER_SIZE & (RING_BUFFER_SIZE - 1)) != 0
+#error "RING_BUFFER_SIZE must be a power of two"
+#endif
+
+typedef struct {
+    unsigned char data[RING_BUFFER_SIZE];
+    volatile unsigned int head;   // Written only by the producer
+    volatile unsigned int tail;   // Written only by the consumer
+} RingBuffer;
+
+void ring_buffer_init(RingBuffer *ring);
+int ring_buffer_put(RingBuffer *ring, unsigned char c);
+int ring_buffer_get(RingBuffer *ring, unsigned char *c);
+unsigned int ring_buffer_count(const RingBuffer *ring);
+size_t ring_buffer_write(RingBuffer *ring, const unsigned char *data, size_t length);
+size_t ring_buffer_peek(const RingBuffer *ring, const unsigned char **data);
+void ring_buffer_consume(RingBuffer *ring, size_t length);
+
+#endif // RING_BUFFER_H
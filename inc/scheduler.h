@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * Cooperative scheduler with a static task table.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SCHEDULER_MAX_TASKS 8
+#define SCHEDULER_ONE_SHOT 0    // Period of a task released once per start
+
+typedef void (*SchedulerTask)(void);
+typedef uint32_t (*SchedulerClock)(void);
+
+typedef struct {
+    SchedulerTask function;
+    uint32_t period;        // Ticks between releases, or SCHEDULER_ONE_SHOT
+    uint32_t deadline;      // Ticks from a release to the completion of the run
+    uint32_t release;       // Tick of the next release
+    bool armed;             // Whether the task is waiting for its release
+    uint32_t runs;          // Number of completed runs
+    uint32_t misses;        // Number of runs completed after their deadline
+    uint32_t max_cycles;    // Longest run time
+    uint64_t total_cycles;  // Sum of the run times
+} Task;
+
+typedef struct {
+    Task tasks[SCHEDULER_MAX_TASKS];
+    unsigned int count;
+    SchedulerClock ticks;   // Time base of the releases
+    SchedulerClock cycles;  // Time base of the run times
+} Scheduler;
+
+void scheduler_init(Scheduler *scheduler, SchedulerClock ticks, SchedulerClock cycles);
+int scheduler_add(Scheduler *scheduler, SchedulerTask function, uint32_t period, uint32_t deadline);
+int scheduler_start(Scheduler *scheduler, int task, uint32_t delay);
+void scheduler_stop(Scheduler *scheduler, int task);
+unsigned int scheduler_run(Scheduler *scheduler);
+bool scheduler_due(const Scheduler *scheduler);
+const Task *scheduler_task(const Scheduler *scheduler, int task);
+
+#endif // SCHEDULER_H
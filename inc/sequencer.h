@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * Keyframe sequencer, interpolating the LED color between uploaded keyframes
+ * from a millisecond tick.
+ */
+
+#ifndef SEQUENCER_H
+#define SEQUENCER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Number of keyframes in the static arena
+#ifndef SEQUENCER_MAX_KEYFRAMES
+#define SEQUENCER_MAX_KEYFRAMES 32
+#endif
+
+// Uploaded keyframe size: r, g, b, easing, duration in ms (2 bytes, LSB first)
+#define SEQUENCER_KEYFRAME_LENGTH 6
+
+// Easing curves of the transition into a keyframe
+#define EASING_LINEAR 0x00
+#define EASING_IN 0x01
+#define EASING_OUT 0x02
+#define EASING_IN_OUT 0x03
+#define EASING_STEP 0x04
+
+// Playback controls of OPCODE_SEQUENCE_CONTROL
+#define SEQUENCE_STOP 0x00
+#define SEQUENCE_PLAY 0x01
+#define SEQUENCE_LOOP 0x02
+
+typedef void (*SequencerOutput)(uint8_t r, uint8_t g, uint8_t b);
+
+typedef struct {
+    uint8_t color[3];
+    uint8_t easing;
+    uint16_t duration_ms;  // Duration of the transition from the previous keyframe
+} Keyframe;
+
+typedef struct {
+    Keyframe keyframes[SEQUENCER_MAX_KEYFRAMES];
+    unsigned int count;
+    unsigned int index;       // Keyframe being transitioned into
+    uint32_t elapsed_ms;      // Time spent in the current transition
+    uint8_t from[3];          // Color at the start of the current transition
+    uint8_t color[3];         // Last color output
+    volatile bool playing;
+    bool loop;
+    SequencerOutput output;
+} Sequencer;
+
+void sequencer_init(Sequencer *seq, SequencerOutput output);
+int sequencer_load(Sequencer *seq, unsigned int first, const uint8_t *data, size_t length);
+int sequencer_play(Sequencer *seq, bool loop, const uint8_t *from);
+void sequencer_stop(Sequencer *seq);
+void sequencer_tick(Sequencer *seq);
+
+#endif // SEQUENCER_H
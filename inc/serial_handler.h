@@ -10,39 +10,107 @@
 #include <stdio.h>
 #include <string.h>
 
-#define BUFFER_SIZE 32
+#define BUFFER_SIZE 128
 
 // Special characters
 #define START_CHAR 0xFF
 #define END_CHAR 0xFE
 #define ESCAPE_CHAR 0xFD
 
+// Length of the optional CRC-16 trailer
+#define CRC_LENGTH 2
+
 // Supported message types
 #define MSG_TYPE_REQUEST 0x00
 #define MSG_TYPE_RESPONSE 0x01
+#define MSG_TYPE_REQUEST_SEQ 0x02   // Request with a sequence number before the opcode
+#define MSG_TYPE_RESPONSE_SEQ 0x03  // Response echoing the sequence number of the request
 
 // Supported opcodes
 #define OPCODE_SET_LED_COLOR 0x00
 #define OPCODE_GET_LED_COLOR 0x01
+#define OPCODE_BATCH 0x02
+#define OPCODE_SET_BAUD_RATE 0x03
+#define OPCODE_GET_UPDATE_PERIOD 0x04
+#define OPCODE_FADE 0x05
+#define OPCODE_UPLOAD_SEQUENCE 0x06
+#define OPCODE_SEQUENCE_CONTROL 0x07
+#define OPCODE_UPLOAD_WAVEFORM 0x08
+#define OPCODE_PLAY_WAVEFORM 0x09
+#define OPCODE_SET_LED_COLOR16 0x0A
+#define OPCODE_SET_CHANNELS 0x0B
+#define OPCODE_SET_PWM_FREQUENCY 0x0C
+#define OPCODE_SET_CHANNEL_COUNT 0x0D
+#define OPCODE_SET_PHASE_STAGGER 0x0E
+#define OPCODE_SET_BRIGHTNESS 0x0F
+#define OPCODE_SET_POWER_BUDGET 0x10
+#define OPCODE_GET_LOAD 0x11
+#define OPCODE_GET_TASK_STATS 0x12
+#define OPCODE_SET_CPU_CLOCK 0x13
+#define OPCODE_GET_PROFILE 0x14
+
+// Command dispatch table
+#define COMMAND_TABLE_SIZE 32           // Opcodes 0..COMMAND_TABLE_SIZE-1 can be registered
+#define PAYLOAD_LENGTH_VARIABLE 0xFF    // The command handler validates the payload length itself
+#define MAX_RESPONSE_LENGTH BUFFER_SIZE
+
+// Longest encoded response: start, escaped header, payload and CRC, end
+#define MAX_FRAME_LENGTH (2 * (2 + MAX_RESPONSE_LENGTH + CRC_LENGTH) + 2)
+
+typedef struct FrameQueue FrameQueue;
+typedef struct SerialPortHandler SerialPortHandler;
 
 typedef void (*CommandCallback)(__uint8_t r, __uint8_t g, __uint8_t b);
 typedef void (*UARTSendCallback)(unsigned char c);
+typedef void (*UARTSendFrameCallback)(const __uint8_t *frame, size_t length);
+
+/**
+ * Handler for a single opcode. Gets the payload following the opcode and
+ * writes its response into the response buffer.
+ * Returns the number of response bytes, 0 for no response.
+ */
+typedef size_t (*CommandHandler)(SerialPortHandler *handler, const __uint8_t *payload, size_t payload_length, __uint8_t *response);
 
 typedef struct {
+    CommandHandler handler;
+    __uint8_t payload_length;   // Expected payload length or PAYLOAD_LENGTH_VARIABLE
+    __uint8_t response_length;  // Maximum response length
+} CommandEntry;
+
+struct SerialPortHandler {
     unsigned char buffer[BUFFER_SIZE];
     int buffer_index;
     int escape_flag;
     int started;
+    int overflow;                   // Bytes of the current frame were dropped
+    int crc_enabled;
+    __uint16_t crc;
+    unsigned int crc_errors;
+    unsigned int overflow_errors;   // Frames dropped for not fitting the buffer
+    unsigned int commands_handled;
+    unsigned int frames_valid;      // Frames that passed the CRC, or name a command without it
+    int sequence_valid;
+    __uint8_t sequence;
     CommandCallback pwm_callback;
     UARTSendCallback send_callback;
+    UARTSendFrameCallback send_frame_callback;
+    __uint8_t tx_frame[MAX_FRAME_LENGTH];
+    FrameQueue *frame_queue;
+    CommandEntry commands[COMMAND_TABLE_SIZE];
     __uint8_t r;
     __uint8_t g;
     __uint8_t b;
-} SerialPortHandler;
+};
 
 void init_serial_port_handler(SerialPortHandler *handler, CommandCallback pwm_callback, UARTSendCallback send_callback);
-void handle_command(const unsigned char *command, SerialPortHandler *handler);
+int serial_register_command(SerialPortHandler *handler, __uint8_t opcode, CommandHandler command_handler, __uint8_t payload_length, __uint8_t response_length);
+void handle_command(const unsigned char *command, size_t length, SerialPortHandler *handler);
 void serial_receive_char(SerialPortHandler *handler, __uint8_t c);
+void serial_receive_bytes(SerialPortHandler *handler, const __uint8_t *buf, size_t len);
+void serial_enable_crc(SerialPortHandler *handler, int enable);
+void serial_set_frame_queue(SerialPortHandler *handler, FrameQueue *queue);
+unsigned int serial_process_frames(SerialPortHandler *handler);
+void serial_set_frame_sender(SerialPortHandler *handler, UARTSendFrameCallback send_frame_callback);
 void send_serial_response(SerialPortHandler *handler, const __uint8_t *response, size_t length);
 
 
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * Temporal dithering of fractional PWM pulse widths. Every period outputs
+ * either the integer part of the width or one more, and the fraction that
+ * was not output is carried to the next period, so the average over
+ * consecutive periods equals the fractional width.
+ */
+
+#include "dither.h"
+
+/**
+ * @brief Starts dithering the given pulse widths.
+ * 
+ * @param dither Pointer to the Dither structure.
+ * @param widths The DITHER_CHANNELS pulse widths, with DITHER_FRACTION_BITS
+ *               fractional bits.
+ */
+void dither_start(Dither *dither, const uint32_t *widths) {
+    for (unsigned int i = 0; i < DITHER_CHANNELS; ++i) {
+        dither->base[i] = widths[i] >> DITHER_FRACTION_BITS;
+        dither->fraction[i] = (uint8_t)widths[i];
+        // Start from half a step, so a single period rounds to the nearest width
+        dither->error[i] = 1 << (DITHER_FRACTION_BITS - 1);
+    }
+}
+
+/**
+ * @brief Computes the pulse widths of the next period.
+ * 
+ * @param dither Pointer to the Dither structure.
+ * @param widths Receives the DITHER_CHANNELS integer pulse widths.
+ */
+void dither_step(Dither *dither, uint32_t *widths) {
+    for (unsigned int i = 0; i < DITHER_CHANNELS; ++i) {
+        const uint32_t sum = (uint32_t)dither->error[i] + dither->fraction[i];
+        widths[i] = dither->base[i] + (sum >> DITHER_FRACTION_BITS);
+        dither->error[i] = (uint8_t)sum;
+    }
+}
+
+/**
+ * @brief Returns true if any channel has a fraction to dither.
+ */
+bool dither_active(const Dither *dither) {
+    for (unsigned int i = 0; i < DITHER_CHANNELS; ++i) {
+        if (dither->fraction[i] != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Stops dithering, dropping the fractions.
+ */
+void dither_stop(Dither *dither) {
+    for (unsigned int i = 0; i < DITHER_CHANNELS; ++i) {
+        dither->fraction[i] = 0;
+    }
+}
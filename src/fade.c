@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * Fixed-point linear fade between two sets of PWM pulse widths. The
+ * increments are computed once when the fade starts, so a step is only an
+ * addition and a shift per channel.
+ */
+
+#include "fade.h"
+
+/**
+ * @brief Starts a fade.
+ * 
+ * Pulse widths must fit in 16 bits. A fade of zero steps ends at the target
+ * on the first step.
+ * 
+ * @param fade Pointer to the Fade structure.
+ * @param from The pulse widths to start from.
+ * @param to The pulse widths to end at.
+ * @param steps The number of steps to reach the target.
+ */
+void fade_start(Fade *fade, const uint32_t *from, const uint32_t *to, uint32_t steps) {
+    if (steps == 0) {
+        steps = 1;
+    }
+    for (unsigned int i = 0; i < FADE_CHANNELS; ++i) {
+        const int64_t delta = (int64_t)to[i] - (int64_t)from[i];
+        fade->value[i] = from[i] << FADE_FRACTION_BITS;
+        // A single step lands on the target, with more the increment fits in 16.16
+        fade->step[i] = steps > 1 ? (int32_t)((delta * (1 << FADE_FRACTION_BITS)) / (int64_t)steps) : 0;
+        fade->target[i] = to[i];
+    }
+    fade->steps_left = steps;
+}
+
+/**
+ * @brief Advances the fade by one step.
+ * 
+ * The last step lands exactly on the target, whatever the rounding of the
+ * increments.
+ * 
+ * @param fade Pointer to the Fade structure.
+ * @param widths Receives the FADE_CHANNELS pulse widths of this step.
+ * @return true if more steps remain, false if the fade has ended.
+ */
+bool fade_step(Fade *fade, uint32_t *widths) {
+    if (fade->steps_left <= 1) {
+        for (unsigned int i = 0; i < FADE_CHANNELS; ++i) {
+            widths[i] = fade->target[i];
+        }
+        fade->steps_left = 0;
+        return false;
+    }
+    for (unsigned int i = 0; i < FADE_CHANNELS; ++i) {
+        fade->value[i] += (uint32_t)fade->step[i];
+        widths[i] = fade->value[i] >> FADE_FRACTION_BITS;
+    }
+    fade->steps_left--;
+    return true;
+}
+
+/**
+ * @brief Returns true while the fade has steps left.
+ */
+bool fade_active(const Fade *fade) {
+    return fade->steps_left != 0;
+}
+
+/**
+ * @brief Stops the fade where it is.
+ */
+void fade_stop(Fade *fade) {
+    fade->steps_left = 0;
+}
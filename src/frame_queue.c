@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * This file is part of the Serial Handler library.
+ */
+
+#include <string.h>
+#include "frame_queue.h"
+
+// Orders the slot accesses against the index updates. On Cortex-M4 this is a DMB.
+#define FRAME_QUEUE_RELEASE() __atomic_thread_fence(__ATOMIC_RELEASE)
+#define FRAME_QUEUE_ACQUIRE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+
+/**
+ * @brief Initializes the frame queue.
+ * 
+ * @param queue Pointer to the FrameQueue structure to initialize.
+ */
+void frame_queue_init(FrameQueue *queue) {
+    queue->head = 0;
+    queue->tail = 0;
+    queue->dropped = 0;
+    queue->high_water = 0;
+}
+
+/**
+ * @brief Copies a frame into the next free slot.
+ * 
+ * Must only be called from the producer side.
+ * 
+ * @param queue Pointer to the FrameQueue structure.
+ * @param data Pointer to the frame data.
+ * @param length Length of the frame data, truncated to BUFFER_SIZE.
+ * @return 0 on success, -1 if the queue is full and the frame was dropped.
+ */
+int frame_queue_push(FrameQueue *queue, const unsigned char *data, size_t length) {
+    const unsigned int head = queue->head;
+    const unsigned int used = head - queue->tail;
+    if (used >= FRAME_QUEUE_DEPTH) {
+        queue->dropped++;
+        return -1;
+    }
+    FRAME_QUEUE_ACQUIRE();
+
+    Frame *slot = &queue->slots[head & (FRAME_QUEUE_DEPTH - 1)];
+    if (length > BUFFER_SIZE) {
+        length = BUFFER_SIZE;
+    }
+    memcpy(slot->data, data, length);
+    slot->length = length;
+
+    FRAME_QUEUE_RELEASE();
+    queue->head = head + 1;
+    if (used + 1 > queue->high_water) {
+        queue->high_water = used + 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Returns the oldest queued frame without removing it.
+ * 
+ * Must only be called from the consumer side. The frame stays valid until
+ * frame_queue_release() is called.
+ * 
+ * @param queue Pointer to the FrameQueue structure.
+ * @return Pointer to the frame, or NULL if the queue is empty.
+ */
+const Frame *frame_queue_peek(FrameQueue *queue) {
+    const unsigned int tail = queue->tail;
+    if (queue->head == tail) {
+        return NULL;
+    }
+    FRAME_QUEUE_ACQUIRE();
+    return &queue->slots[tail & (FRAME_QUEUE_DEPTH - 1)];
+}
+
+/**
+ * @brief Removes the oldest queued frame, freeing its slot for the producer.
+ * 
+ * @param queue Pointer to the FrameQueue structure.
+ */
+void frame_queue_release(FrameQueue *queue) {
+    FRAME_QUEUE_RELEASE();
+    queue->tail = queue->tail + 1;
+}
+
+/**
+ * @brief Returns the number of frames currently queued.
+ * 
+ * @param queue Pointer to the FrameQueue structure.
+ */
+unsigned int frame_queue_count(const FrameQueue *queue) {
+    return queue->head - queue->tail;
+}
@@ -14,37 +14,317 @@
 #include "inc/hw_memmap.h"
 #include "inc/hw_types.h"
 #include "inc/hw_ints.h"
+#include "inc/hw_uart.h"
 #include "driverlib/interrupt.h"
 #include "driverlib/sysctl.h"
 #include "driverlib/gpio.h"
 #include "driverlib/uart.h"
 #include "driverlib/pin_map.h"
-#include "driverlib/pwm.h"
+#include "driverlib/udma.h"
+#include "driverlib/systick.h"
+#include "driverlib/timer.h"
+#include "driverlib/cpu.h"
 #include "driverlib/rom.h"
 #include "driverlib/rom_map.h"
 
 // User libraries
 #include "led_pwm.h"
 #include "serial_handler.h"
-
-// LED configuration
-#define LED_R_PWM_OUT PWM_OUT_5
-#define LED_G_PWM_OUT PWM_OUT_7
-#define LED_B_PWM_OUT PWM_OUT_6
+#include "frame_queue.h"
+#include "ring_buffer.h"
+#include "pwm_output.h"
+#include "gamma_table.h"
+#include "sequencer.h"
+#include "scheduler.h"
+#include "profile.h"
 
 // UART configuration
-#define BAUD_RATE 9600    // 9600 bps
+#define BAUD_RATE 9600    // 9600 bps, initial rate after reset
+#define UART_CONFIG (UART_CONFIG_WLEN_8 | UART_CONFIG_STOP_ONE | UART_CONFIG_PAR_NONE)
+#define BAUD_RATE_TIMEOUT_MS 1000   // Revert a new baud rate if no frame is received at it within this time
+#define UART_FIFO_DEPTH 16  // Depth of the UART receive FIFO
+#define SERIAL_CRC 0        // Set to 1 to require a CRC-16 trailer in every frame
+#define UART_RX_DMA 1       // Set to 0 to receive through the RX FIFO interrupt instead of uDMA
+#define UART_RX_DMA_BUFFER_SIZE 64  // Size of each of the two uDMA receive buffers
+#define UART_TX_DMA 1       // Set to 0 to send responses through the TX FIFO interrupt instead of uDMA
+#define UDMA_MAX_TRANSFER 1024      // Maximum number of items in one uDMA transfer
+
+// SysTick configuration
+#define SYSTICK_HZ 1000     // 1 ms tick
+
+// Interrupt priorities below PWM_OUTPUT_INT_PRIORITY, lower values preempt
+#define UART_INT_PRIORITY 0x40      // Framing and uDMA of the serial link
+#define SYSTICK_INT_PRIORITY 0x80   // Time base of the scheduler
+#define PENDSV_INT_PRIORITY 0xE0    // Command execution, the lowest
+
+// Free-running timer counting system clock cycles for the load statistics
+#define LOAD_TIMER_PERIPH SYSCTL_PERIPH_TIMER3
+#define LOAD_TIMER_BASE TIMER3_BASE
+
+// uDMA channel control table, must be aligned to 1024 bytes
+static uint8_t udma_control_table[1024] __attribute__ ((aligned(1024)));
 
 // UART handler
 SerialPortHandler handler;
 
+// Milliseconds since start-up, incremented by SysTick
+static volatile uint32_t ms_ticks;
+
+// Baud rate negotiation state
+static uint32_t baud_rate = BAUD_RATE;
+static uint32_t previous_baud_rate;
+static volatile uint32_t pending_baud_rate;
+
+// System clock presets selected by SET_CPU_CLOCK
+typedef struct {
+    uint32_t config;    // SysCtlClockSet() configuration
+    uint32_t hz;        // Resulting system clock frequency
+} ClockPreset;
+
+static const ClockPreset clock_presets[CPU_CLOCK_PRESETS] = {
+    [CPU_CLOCK_16MHZ] = {SYSCTL_SYSDIV_1 | SYSCTL_USE_OSC | SYSCTL_OSC_INT | SYSCTL_MAIN_OSC_DIS, 16000000},
+    [CPU_CLOCK_40MHZ] = {SYSCTL_SYSDIV_5 | SYSCTL_USE_PLL | SYSCTL_OSC_MAIN | SYSCTL_XTAL_16MHZ, 40000000},
+    [CPU_CLOCK_50MHZ] = {SYSCTL_SYSDIV_4 | SYSCTL_USE_PLL | SYSCTL_OSC_MAIN | SYSCTL_XTAL_16MHZ, 50000000},
+    [CPU_CLOCK_80MHZ] = {SYSCTL_SYSDIV_2_5 | SYSCTL_USE_PLL | SYSCTL_OSC_MAIN | SYSCTL_XTAL_16MHZ, 80000000},
+};
+
+// Preset to switch to once the UART is idle, or CPU_CLOCK_PRESETS for none
+static volatile unsigned int pending_clock_preset = CPU_CLOCK_PRESETS;
+
+// Frames received in the UART ISR, executed in the PendSV handler
+static FrameQueue frame_queue;
+
+// Bytes waiting for transmission, moved to the UART FIFO by the TX interrupt
+static RingBuffer tx_ring;
+
+#if RING_BUFFER_SIZE < MAX_FRAME_LENGTH
+#error "The transmit ring must hold a whole response frame, or sending waits in PendSV"
+#endif
+
+#if PWM_WAVEFORM_MAX_SAMPLES > 255
+#error "UPLOAD_WAVEFORM reports the waveform length in one byte"
+#endif
+
+// Keyframe animation, loaded, controlled and played in the main loop
+static Sequencer sequencer;
+static uint32_t sequencer_ms;
+
+// Tasks run from the main loop, released by SysTick
+static Scheduler scheduler;
+static int sequencer_task_id;
+static int baud_rate_task_id;
+static int baud_rate_revert_task_id;
+static int clock_task_id;
+static int phase_task_id;
+
+// Tasks to start, one bit per task, set by the commands that arm them
+static volatile uint32_t task_requests;
+
+// System clock cycles spent asleep in the main loop
+static uint32_t idle_cycles;
+
+/**
+ * @brief Moves bytes from the TX ring to the UART transmit FIFO.
+ * 
+ * Runs until the FIFO is full or the ring is empty. Must be called either
+ * from the UART ISR or with the UART TX interrupt masked, as it is the
+ * consumer side of the ring.
+ */
+static void uart_tx_fill(void)
+{
+    unsigned char c;
+    while (UARTSpaceAvail(UART1_BASE) && ring_buffer_get(&tx_ring, &c) == 0) {
+        UARTCharPutNonBlocking(UART1_BASE, c);
+    }
+}
+
+#if UART_TX_DMA
+// Number of bytes at the tail of the TX ring being sent by uDMA, 0 when idle
+static size_t tx_dma_length;
+
+/**
+ * @brief Advances the uDMA transmit channel.
+ * 
+ * Releases the ring bytes of a completed transfer and starts a new transfer
+ * for the next contiguous run in the TX ring. Must be called either from the
+ * UART ISR or with the UART interrupt disabled, as it is the consumer side of
+ * the ring.
+ */
+static void uart_tx_dma_service(void)
+{
+    const unsigned char *data;
+    size_t length;
+
+    if (tx_dma_length != 0) {
+        if (uDMAChannelModeGet(UDMA_CHANNEL_UART1TX | UDMA_PRI_SELECT) != UDMA_MODE_STOP) {
+            return;
+        }
+        ring_buffer_consume(&tx_ring, tx_dma_length);
+        tx_dma_length = 0;
+    }
+
+    length = ring_buffer_peek(&tx_ring, &data);
+    if (length == 0) {
+        return;
+    }
+    if (length > UDMA_MAX_TRANSFER) {
+        length = UDMA_MAX_TRANSFER;
+    }
+    uDMAChannelTransferSet(UDMA_CHANNEL_UART1TX | UDMA_PRI_SELECT, UDMA_MODE_BASIC,
+                           (void *)data, (void *)(UART1_BASE + UART_O_DR), length);
+    tx_dma_length = length;
+    uDMAChannelEnable(UDMA_CHANNEL_UART1TX);
+}
+
+/**
+ * @brief Configures uDMA transmission for UART1.
+ * 
+ * Completion of a transfer raises the UART1 interrupt.
+ */
+static void uart_tx_dma_init(void)
+{
+    uDMAChannelAssign(UDMA_CH23_UART1TX);
+    uDMAChannelAttributeDisable(UDMA_CHANNEL_UART1TX, UDMA_ATTR_ALTSELECT | UDMA_ATTR_HIGH_PRIORITY | UDMA_ATTR_REQMASK | UDMA_ATTR_USEBURST);
+    uDMAChannelControlSet(UDMA_CHANNEL_UART1TX | UDMA_PRI_SELECT, UDMA_SIZE_8 | UDMA_SRC_INC_8 | UDMA_DST_INC_NONE | UDMA_ARB_4);
+    tx_dma_length = 0;
+    UARTDMAEnable(UART1_BASE, UART_DMA_TX);
+}
+#endif
+
+/**
+ * @brief Reads everything in the UART receive FIFO and decodes it.
+ */
+static void uart_rx_drain_fifo(void)
+{
+    __uint8_t rx_bytes[UART_FIFO_DEPTH];
+    size_t rx_count = 0;
+
+    while(UARTCharsAvail(UART1_BASE))
+    {
+        rx_bytes[rx_count++] = (__uint8_t)UARTCharGetNonBlocking(UART1_BASE);
+        if (rx_count == UART_FIFO_DEPTH) {
+            serial_receive_bytes(&handler, rx_bytes, rx_count);
+            rx_count = 0;
+        }
+    }
+    serial_receive_bytes(&handler, rx_bytes, rx_count);
+}
+
+#if UART_RX_DMA
+// Ping-pong receive buffers: index 0 is the primary, 1 the alternate control structure
+static __uint8_t rx_dma_buffers[2][UART_RX_DMA_BUFFER_SIZE];
+static size_t rx_dma_consumed[2];
+static int rx_dma_active;
+static const uint32_t rx_dma_select[2] = {UDMA_PRI_SELECT, UDMA_ALT_SELECT};
+
+/**
+ * @brief Hands the bytes landed in a receive buffer to the serial handler.
+ * 
+ * @param index The receive buffer.
+ * @param end Number of bytes landed in the buffer so far.
+ */
+static void uart_rx_dma_consume(int index, size_t end)
+{
+    if (end > rx_dma_consumed[index]) {
+        serial_receive_bytes(&handler, &rx_dma_buffers[index][rx_dma_consumed[index]], end - rx_dma_consumed[index]);
+        rx_dma_consumed[index] = end;
+    }
+}
+
+/**
+ * @brief Sets up a receive buffer for the next ping-pong transfer.
+ * 
+ * @param index The receive buffer.
+ */
+static void uart_rx_dma_arm(int index)
+{
+    rx_dma_consumed[index] = 0;
+    uDMAChannelTransferSet(UDMA_CHANNEL_UART1RX | rx_dma_select[index], UDMA_MODE_PINGPONG,
+                           (void *)(UART1_BASE + UART_O_DR), rx_dma_buffers[index], UART_RX_DMA_BUFFER_SIZE);
+}
+
+/**
+ * @brief Services the uDMA receive channel from the UART ISR.
+ * 
+ * Full buffers are decoded and re-armed in the order they were filled, then
+ * the part of the active buffer filled so far. On a receive timeout, DMA
+ * requests are stopped first so no burst can land while the buffers are
+ * walked, and the bytes still in the FIFO (less than one burst) are decoded
+ * last, in arrival order.
+ * 
+ * @param timeout Non-zero if the receive timeout interrupt was asserted.
+ */
+static void uart_rx_dma_service(int timeout)
+{
+    if (timeout) {
+        UARTDMADisable(UART1_BASE, UART_DMA_RX);
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        if (uDMAChannelModeGet(UDMA_CHANNEL_UART1RX | rx_dma_select[rx_dma_active]) != UDMA_MODE_STOP) {
+            break;
+        }
+        uart_rx_dma_consume(rx_dma_active, UART_RX_DMA_BUFFER_SIZE);
+        uart_rx_dma_arm(rx_dma_active);
+        rx_dma_active ^= 1;
+    }
+
+    const size_t remaining = uDMAChannelSizeGet(UDMA_CHANNEL_UART1RX | rx_dma_select[rx_dma_active]);
+    uart_rx_dma_consume(rx_dma_active, UART_RX_DMA_BUFFER_SIZE - remaining);
+    if (timeout) {
+        uart_rx_drain_fifo();
+        UARTDMAEnable(UART1_BASE, UART_DMA_RX);
+    }
+}
+
+/**
+ * @brief Checks for received bytes left in the active buffer, from SysTick.
+ * 
+ * The receive timeout is only raised for bytes left in the FIFO. When a
+ * frame ends with a full burst, the uDMA empties the FIFO, no timeout
+ * follows and the frame would wait in the buffer for the next bytes. The
+ * UART interrupt is pended to decode it instead, within a millisecond.
+ */
+static void uart_rx_dma_poll(void)
+{
+    const size_t remaining = uDMAChannelSizeGet(UDMA_CHANNEL_UART1RX | rx_dma_select[rx_dma_active]);
+    if (UART_RX_DMA_BUFFER_SIZE - remaining > rx_dma_consumed[rx_dma_active]) {
+        IntPendSet(INT_UART1);
+    }
+}
+
+/**
+ * @brief Configures uDMA ping-pong reception for UART1.
+ * 
+ * The UART requests a burst of 8 bytes whenever the RX FIFO is half full,
+ * so the CPU is only interrupted when a buffer is full or the line goes idle.
+ */
+static void uart_rx_dma_init(void)
+{
+    uDMAChannelAssign(UDMA_CH22_UART1RX);
+    uDMAChannelAttributeDisable(UDMA_CHANNEL_UART1RX, UDMA_ATTR_ALTSELECT | UDMA_ATTR_HIGH_PRIORITY | UDMA_ATTR_REQMASK);
+    uDMAChannelAttributeEnable(UDMA_CHANNEL_UART1RX, UDMA_ATTR_USEBURST);
+    uDMAChannelControlSet(UDMA_CHANNEL_UART1RX | UDMA_PRI_SELECT, UDMA_SIZE_8 | UDMA_SRC_INC_NONE | UDMA_DST_INC_8 | UDMA_ARB_8);
+    uDMAChannelControlSet(UDMA_CHANNEL_UART1RX | UDMA_ALT_SELECT, UDMA_SIZE_8 | UDMA_SRC_INC_NONE | UDMA_DST_INC_8 | UDMA_ARB_8);
+    uart_rx_dma_arm(0);
+    uart_rx_dma_arm(1);
+    rx_dma_active = 0;
+    uDMAChannelEnable(UDMA_CHANNEL_UART1RX);
+    UARTDMAEnable(UART1_BASE, UART_DMA_RX);
+}
+#endif
+
 /**
  * @brief UART1 interrupt handler.
  * 
- * This function is called when a character is received on UART1.
+ * This function is called when the UART1 receive FIFO reaches its trigger
+ * level or times out, when a uDMA receive buffer is full or a uDMA transmit
+ * completes, or when the transmit FIFO drops below its trigger level. Received characters are
+ * handed to the serial handler a span at a time.
  */
 void UARTIntHandler(void) // cppcheck-suppress unusedFunction - this is defined in the ISR vector table
 {
+    PROFILE_BEGIN(start);
     uint32_t ui32Status;
 
     //
@@ -58,42 +338,780 @@ void UARTIntHandler(void) // cppcheck-suppress unusedFunction - this is defined
     UARTIntClear(UART1_BASE, ui32Status);
 
     //
-    // Loop while there are characters in the receive FIFO.
+    // Refill the transmit FIFO from the TX ring.
     //
-    while(UARTCharsAvail(UART1_BASE))
-    {
-        serial_receive_char(&handler, UARTCharGetNonBlocking(UART1_BASE));
+    if (ui32Status & UART_INT_TX) {
+        uart_tx_fill();
     }
+#if UART_TX_DMA
+    uart_tx_dma_service();
+#endif
+
+#if UART_RX_DMA
+    //
+    // Decode the received buffers. uDMA completion has no status bit of its own.
+    //
+    uart_rx_dma_service((ui32Status & UART_INT_RT) != 0);
+#else
+    //
+    // Drain the receive FIFO and decode the characters in one pass.
+    //
+    uart_rx_drain_fifo();
+#endif
+
+    //
+    // Execute the completed frames at the lowest priority.
+    //
+    if (frame_queue_count(&frame_queue) != 0) {
+        IntPendSet(FAULT_PENDSV);
+    }
+    PROFILE_END(PROFILE_UART_ISR, start);
+}
+
+/**
+ * @brief PendSV interrupt handler.
+ * 
+ * Executes the commands of the frames queued by the UART ISR. At the lowest
+ * priority, a long command is preempted by every other interrupt.
+ */
+void PendSVIntHandler(void) // cppcheck-suppress unusedFunction - this is defined in the ISR vector table
+{
+    serial_process_frames(&handler);
+}
+
+/**
+ * @brief SysTick interrupt handler.
+ * 
+ * Keeps the millisecond time base that releases the scheduler tasks, and
+ * flushes received bytes that raised no receive timeout.
+ */
+void SysTickIntHandler(void) // cppcheck-suppress unusedFunction - this is defined in the ISR vector table
+{
+    ms_ticks++;
+#if UART_RX_DMA
+    uart_rx_dma_poll();
+#endif
+}
+
+/**
+ * @brief Returns the scheduler tick, in milliseconds.
+ */
+static uint32_t scheduler_ticks(void)
+{
+    return ms_ticks;
+}
+
+/**
+ * @brief Asks the main loop to start a task.
+ * 
+ * Commands run in PendSV, which may preempt scheduler_run() in the middle
+ * of updating a task, so they do not start tasks themselves.
+ */
+static void request_task(int task)
+{
+    const uint32_t basepri = CPUbasepriGet();
+    CPUbasepriSet(PENDSV_INT_PRIORITY);
+    task_requests |= 1u << task;
+    CPUbasepriSet(basepri);
+}
+
+/**
+ * @brief Starts the phase task if a PWM change left the generators to be
+ * restarted.
+ * 
+ * Restarting them waits for up to a PWM period per generator, which would
+ * hold up the commands in PendSV.
+ */
+static void request_phases(void)
+{
+    if (pwm_output_phases_pending()) {
+        request_task(phase_task_id);
+    }
+}
+
+/**
+ * @brief Returns the system clock cycles counted by the load timer.
+ */
+static uint32_t load_timer_cycles(void)
+{
+    // The timer counts down from its load value
+    return 0xFFFFFFFF - TimerValueGet(LOAD_TIMER_BASE, TIMER_A);
+}
+
+/**
+ * @brief Checks that UART1 can run at a baud rate with a system clock.
+ * 
+ * Above clock/16 the UART runs in high-speed mode (clock/8), and the integer
+ * part of the baud rate divisor must fit in 16 bits.
+ * 
+ * @param baud The baud rate.
+ * @param clock The system clock frequency in Hz.
+ * @return true if the baud rate can be configured.
+ */
+static bool uart_baud_rate_valid(uint32_t baud, uint32_t clock)
+{
+    return (baud != 0) && (baud <= clock / 8) && ((clock / 16) / baud <= 0xFFFF);
+}
+
+/**
+ * @brief Command handler for OPCODE_SET_BAUD_RATE.
+ * 
+ * The payload is the new baud rate, least significant byte first. The
+ * response (1 accepted, 0 rejected) is sent at the old rate, and the switch
+ * is made by baud_rate_service() once it has left the UART.
+ */
+static size_t set_baud_rate_command(SerialPortHandler *port, const __uint8_t *payload, size_t payload_length, __uint8_t *response)
+{
+    (void)port;
+    (void)payload_length;
+    const uint32_t baud = (uint32_t)payload[0] | ((uint32_t)payload[1] << 8) |
+                          ((uint32_t)payload[2] << 16) | ((uint32_t)payload[3] << 24);
+    if (!uart_baud_rate_valid(baud, SysCtlClockGet())) {
+        response[0] = 0;
+        return 1;
+    }
+    pending_baud_rate = baud;
+    request_task(baud_rate_task_id);
+    response[0] = 1;
+    return 1;
+}
+
+/**
+ * @brief Applies a pending baud rate change, a periodic task started by
+ * SET_BAUD_RATE.
+ * 
+ * The change is applied once all queued output has been sent, and the
+ * revert task is started to check it after BAUD_RATE_TIMEOUT_MS. The task
+ * then stops itself. PendSV is masked so that no response is queued
+ * between the check and the change. The UART interrupt is held off while
+ * the frame counter is cleared with the reconfiguration, so frames received
+ * at the old rate, queued or not, are not taken as proof that the new rate
+ * works.
+ */
+static void baud_rate_service(void)
+{
+    CPUbasepriSet(PENDSV_INT_PRIORITY);
+    if (pending_baud_rate != 0 && ring_buffer_count(&tx_ring) == 0 && !UARTBusy(UART1_BASE)) {
+        previous_baud_rate = baud_rate;
+        baud_rate = pending_baud_rate;
+        pending_baud_rate = 0;
+        IntDisable(INT_UART1);
+        UARTConfigSetExpClk(UART1_BASE, SysCtlClockGet(), baud_rate, UART_CONFIG);
+        handler.frames_valid = 0;
+        IntEnable(INT_UART1);
+        scheduler_start(&scheduler, baud_rate_revert_task_id, BAUD_RATE_TIMEOUT_MS);
+    }
+    if (pending_baud_rate == 0) {
+        scheduler_stop(&scheduler, baud_rate_task_id);
+    }
+    CPUbasepriSet(0);
+}
+
+/**
+ * @brief Restores the previous baud rate unless a valid frame was received
+ * at the new one, a one-shot task.
+ * 
+ * A valid frame is one that passed the CRC, or without CRC one that names a
+ * registered command with its payload length. The fallback is only as safe
+ * as that check: without CRC, noise at the new rate that happens to form
+ * such a frame keeps a rate the host cannot use, so enable CRC before
+ * changing the rate.
+ */
+static void baud_rate_revert(void)
+{
+    CPUbasepriSet(PENDSV_INT_PRIORITY);
+    if (handler.frames_valid == 0) {
+        baud_rate = previous_baud_rate;
+        UARTConfigSetExpClk(UART1_BASE, SysCtlClockGet(), baud_rate, UART_CONFIG);
+    }
+    CPUbasepriSet(0);
+}
+
+/**
+ * @brief Requests a switch of the system clock to a preset.
+ * 
+ * The switch is made by clock_service() once all queued output has left the
+ * UART, so a response already queued is sent at the old clock. The preset
+ * is rejected if the baud rate or the PWM frequency cannot be kept with it.
+ * 
+ * @param preset One of the CPU_CLOCK_ presets.
+ * @return 0 if the switch was requested, -1 if the preset was rejected.
+ */
+int cpu_clock_set(unsigned int preset)
+{
+    if (preset >= CPU_CLOCK_PRESETS) {
+        return -1;
+    }
+    const uint32_t hz = clock_presets[preset].hz;
+    if (!uart_baud_rate_valid(baud_rate, hz) ||
+        (pending_baud_rate != 0 && !uart_baud_rate_valid(pending_baud_rate, hz)) ||
+        !pwm_output_frequency_valid(pwm_output_frequency(), hz)) {
+        return -1;
+    }
+    pending_clock_preset = preset;
+    request_task(clock_task_id);
+    return 0;
+}
+
+/**
+ * @brief Command handler for OPCODE_SET_CPU_CLOCK.
+ * 
+ * The payload is the index of a system clock preset: 0 16 MHz from the
+ * internal oscillator, 1 40 MHz, 2 50 MHz, 3 80 MHz from the PLL. Responds
+ * with 1 if cpu_clock_set() accepted it, 0 otherwise.
+ */
+static size_t set_cpu_clock_command(SerialPortHandler *port, const __uint8_t *payload, size_t payload_length, __uint8_t *response)
+{
+    (void)port;
+    (void)payload_length;
+    response[0] = cpu_clock_set(payload[0]) == 0;
+    return 1;
+}
+
+/**
+ * @brief Applies a pending system clock change, a periodic task started by
+ * SET_CPU_CLOCK.
+ * 
+ * Waits until all queued output has been sent, then switches the clock and
+ * reprograms everything derived from it: the UART baud rate divisor, the
+ * SysTick period and the PWM periods, which keep their frequency and duty
+ * cycles, and stops itself. PendSV is masked so that no response is queued
+ * meanwhile.
+ */
+static void clock_service(void)
+{
+    CPUbasepriSet(PENDSV_INT_PRIORITY);
+    if (pending_clock_preset < CPU_CLOCK_PRESETS && ring_buffer_count(&tx_ring) == 0 && !UARTBusy(UART1_BASE)) {
+        const uint32_t pwm_hz = pwm_output_frequency();
+        SysCtlClockSet(clock_presets[pending_clock_preset].config);
+        pending_clock_preset = CPU_CLOCK_PRESETS;
+
+        const uint32_t clock = SysCtlClockGet();
+        UARTConfigSetExpClk(UART1_BASE, clock, baud_rate, UART_CONFIG);
+        SysTickPeriodSet(clock / SYSTICK_HZ);
+        pwm_output_set_frequency(pwm_hz);
+        request_phases();
+    }
+    if (pending_clock_preset >= CPU_CLOCK_PRESETS) {
+        scheduler_stop(&scheduler, clock_task_id);
+    }
+    CPUbasepriSet(0);
+}
+
+/**
+ * @brief Plays the keyframe sequence, a periodic task started by
+ * SEQUENCE_CONTROL.
+ * 
+ * Steps the sequence once for every millisecond since the last run, so a
+ * late release does not slow the animation down, and stops itself when the
+ * sequence is no longer playing. The sequence commands run in PendSV, which
+ * is masked meanwhile; all other interrupts stay enabled.
+ */
+static void sequencer_task(void)
+{
+    CPUbasepriSet(PENDSV_INT_PRIORITY);
+    const uint32_t now = ms_ticks;
+    while (sequencer_ms != now) {
+        sequencer_ms++;
+        sequencer_tick(&sequencer);
+    }
+    if (!sequencer.playing) {
+        scheduler_stop(&scheduler, sequencer_task_id);
+    }
+    CPUbasepriSet(0);
+}
+
+/**
+ * @brief Starts the tasks requested by commands, from the main loop.
+ */
+static void start_requested_tasks(void)
+{
+    CPUbasepriSet(PENDSV_INT_PRIORITY);
+    const uint32_t requests = task_requests;
+    task_requests = 0;
+    CPUbasepriSet(0);
+    for (int task = 0; task < SCHEDULER_MAX_TASKS; ++task) {
+        if (requests & (1u << task)) {
+            scheduler_start(&scheduler, task, 1);
+        }
+    }
+}
+
+/**
+ * @brief Sleeps until the next interrupt if no task is due or requested.
+ * 
+ * The check and the sleep run with interrupts masked: a task released or
+ * requested after the check leaves SysTick or PendSV pending, which ends
+ * the sleep, and is taken when interrupts are unmasked. This needs PRIMASK, as interrupts masked by
+ * BASEPRI do not wake the core. Commands are executed by PendSV. The
+ * peripherals in use keep their clocks in sleep, the others are gated.
+ */
+static void idle(void)
+{
+    IntMasterDisable();
+    if (!scheduler_due(&scheduler) && task_requests == 0) {
+        const uint32_t start = TimerValueGet(LOAD_TIMER_BASE, TIMER_A);
+        CPUwfi();
+        // The timer counts down
+        idle_cycles += start - TimerValueGet(LOAD_TIMER_BASE, TIMER_A);
+    }
+    IntMasterEnable();
+}
+
+/**
+ * @brief Command handler for OPCODE_GET_LOAD.
+ * 
+ * Responds with the system clock cycles spent asleep and awake since
+ * start-up, both 4 bytes least significant byte first. The counters wrap,
+ * so the load is computed from the differences of two readings.
+ */
+static size_t get_load_command(SerialPortHandler *port, const __uint8_t *payload, size_t payload_length, __uint8_t *response)
+{
+    (void)port;
+    (void)payload;
+    (void)payload_length;
+    const uint32_t cycles[2] = {idle_cycles, load_timer_cycles() - idle_cycles};
+    for (int i = 0; i < 2; ++i) {
+        response[4 * i] = (__uint8_t)cycles[i];
+        response[4 * i + 1] = (__uint8_t)(cycles[i] >> 8);
+        response[4 * i + 2] = (__uint8_t)(cycles[i] >> 16);
+        response[4 * i + 3] = (__uint8_t)(cycles[i] >> 24);
+    }
+    return 8;
+}
+
+/**
+ * @brief Command handler for OPCODE_GET_TASK_STATS.
+ * 
+ * Responds with the statistics of the scheduler task numbered in the
+ * payload: runs, deadline misses, longest and mean run time in system clock
+ * cycles, each 4 bytes least significant byte first. Responds with 0 if
+ * there is no such task.
+ */
+static size_t get_task_stats_command(SerialPortHandler *port, const __uint8_t *payload, size_t payload_length, __uint8_t *response)
+{
+    (void)port;
+    (void)payload_length;
+    const Task *task = scheduler_task(&scheduler, payload[0]);
+    if (task == NULL) {
+        response[0] = 0;
+        return 1;
+    }
+    const uint32_t stats[4] = {
+        task->runs, task->misses, task->max_cycles,
+        task->runs == 0 ? 0 : (uint32_t)(task->total_cycles / task->runs)
+    };
+    for (int i = 0; i < 4; ++i) {
+        response[4 * i] = (__uint8_t)stats[i];
+        response[4 * i + 1] = (__uint8_t)(stats[i] >> 8);
+        response[4 * i + 2] = (__uint8_t)(stats[i] >> 16);
+        response[4 * i + 3] = (__uint8_t)(stats[i] >> 24);
+    }
+    return 16;
+}
+
+/**
+ * @brief Command handler for OPCODE_GET_PROFILE.
+ * 
+ * Responds with the measurements of every profiled region, in the order of
+ * ProfileRegionId: count, minimum, maximum and mean in system clock cycles,
+ * each 4 bytes least significant byte first. A non-zero payload clears the
+ * measurements after they are read. All zero when built with PROFILE 0.
+ */
+static size_t get_profile_command(SerialPortHandler *port, const __uint8_t *payload, size_t payload_length, __uint8_t *response)
+{
+    (void)port;
+    (void)payload_length;
+    // The regions are measured by interrupts up to the PWM priority
+    CPUbasepriSet(PWM_OUTPUT_INT_PRIORITY);
+    for (int r = 0; r < PROFILE_REGIONS; ++r) {
+        const ProfileRegion *region = profile_region((ProfileRegionId)r);
+        const uint32_t stats[4] = {
+            region->count,
+            region->count == 0 ? 0 : region->min_cycles,
+            region->max_cycles,
+            region->count == 0 ? 0 : (uint32_t)(region->total_cycles / region->count)
+        };
+        for (int i = 0; i < 4; ++i) {
+            __uint8_t *out = &response[16 * r + 4 * i];
+            out[0] = (__uint8_t)stats[i];
+            out[1] = (__uint8_t)(stats[i] >> 8);
+            out[2] = (__uint8_t)(stats[i] >> 16);
+            out[3] = (__uint8_t)(stats[i] >> 24);
+        }
+    }
+    if (payload[0] != 0) {
+        profile_reset();
+    }
+    CPUbasepriSet(0);
+    return 16 * PROFILE_REGIONS;
 }
 
 /**
  * @brief Handles the PWM signal for the LED.
  * 
  * This function sets the PWM signal for the LED based on the received values.
+ * The three channels are committed together at the start of the next period.
  * 
  * @param r The red value.
  * @param g The green value.
  * @param b The blue value.
  */
 void led_pwm_handler(__uint8_t r, __uint8_t g, __uint8_t b) {
-    // Set the LED colors by PWM. As our period is 100, we can use the received values directly.
-    PWMPulseWidthSet(PWM1_BASE, LED_R_PWM_OUT, r);
-    PWMPulseWidthSet(PWM1_BASE, LED_G_PWM_OUT, g);
-    PWMPulseWidthSet(PWM1_BASE, LED_B_PWM_OUT, b);
+    // A color from the host takes over from a playing sequence
+    sequencer_stop(&sequencer);
+
+    // Set the LED colors by PWM. The gamma table maps the 8-bit values to pulse widths of the PWM period.
+    pwm_output_set_rgb(gamma_table[r], gamma_table[g], gamma_table[b]);
+}
+
+/**
+ * @brief Maps a 16-bit color value to a pulse width through the gamma table.
+ * 
+ * The value is placed between two table entries and the width interpolated
+ * between them, with 8 fractional bits.
+ * 
+ * @param value The color value, 0..65535.
+ * @return The pulse width in 1/256 PWM clock cycles.
+ */
+static uint32_t gamma_fine(uint16_t value)
+{
+    // Position in the table in 1/256 steps, 0..255 * 256
+    const uint32_t position = ((uint32_t)value * (GAMMA_TABLE_SIZE - 1) + 128) >> 8;
+    const uint32_t index = position >> 8;
+    const uint32_t fraction = position & 0xFF;
+    const uint32_t next = index < GAMMA_TABLE_SIZE - 1 ? gamma_table[index + 1] : gamma_table[index];
+    return gamma_table[index] * (256 - fraction) + next * fraction;
+}
+
+/**
+ * @brief Command handler for OPCODE_SET_LED_COLOR16.
+ * 
+ * Sets the color from 16-bit values (2 bytes each, LSB first); 12-bit
+ * colors are sent shifted left by 4. The fraction of the gamma-corrected
+ * pulse width is dithered over consecutive PWM periods.
+ */
+static size_t set_led_color16_command(SerialPortHandler *port, const __uint8_t *payload, size_t payload_length, __uint8_t *response)
+{
+    (void)payload_length;
+    uint16_t rgb[3];
+    for (int i = 0; i < 3; ++i) {
+        rgb[i] = (uint16_t)(payload[2 * i] | (payload[2 * i + 1] << 8));
+    }
+    sequencer_stop(&sequencer);
+    port->r = (__uint8_t)(rgb[0] >> 8);
+    port->g = (__uint8_t)(rgb[1] >> 8);
+    port->b = (__uint8_t)(rgb[2] >> 8);
+    pwm_output_set_rgb_fine(gamma_fine(rgb[0]), gamma_fine(rgb[1]), gamma_fine(rgb[2]));
+    response[0] = 1;
+    return 1;
+}
+
+/**
+ * @brief Command handler for OPCODE_SET_CHANNELS.
+ * 
+ * Payload byte 0 is the first channel, followed by 8-bit values of
+ * consecutive channels, which are gamma corrected like colors. Writing any
+ * of the LED channels 0..2 stops a playing sequence. Responds with 1 on
+ * success, 0 if the range is not within PWM_CHANNEL_COUNT.
+ */
+static size_t set_channels_command(SerialPortHandler *port, const __uint8_t *payload, size_t payload_length, __uint8_t *response)
+{
+    (void)port;
+    uint32_t values[PWM_CHANNEL_COUNT];
+    const size_t count = payload_length - 1;
+    response[0] = 0;
+    if (payload_length < 2 || count > PWM_CHANNEL_COUNT) {
+        return 1;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        values[i] = gamma_table[payload[1 + i]];
+    }
+    if (payload[0] < PWM_LED_CHANNELS) {
+        sequencer_stop(&sequencer);
+    }
+    response[0] = pwm_output_set_channels(payload[0], values, (unsigned int)count) == 0 ? 1 : 0;
+    return 1;
+}
+
+/**
+ * @brief Outputs a color of the playing sequence, called from the sequencer task.
+ */
+static void sequencer_output(uint8_t r, uint8_t g, uint8_t b)
+{
+    handler.r = r;
+    handler.g = g;
+    handler.b = b;
+    pwm_output_set_rgb(gamma_table[r], gamma_table[g], gamma_table[b]);
+}
+
+/**
+ * @brief Command handler for OPCODE_UPLOAD_SEQUENCE.
+ * 
+ * Payload byte 0 is the index of the first keyframe, followed by keyframes
+ * of r, g, b, easing and duration in ms (2 bytes, LSB first). Stops a
+ * playing sequence. Responds with the number of keyframes in the sequence,
+ * or 0 if the upload was rejected.
+ */
+static size_t upload_sequence_command(SerialPortHandler *port, const __uint8_t *payload, size_t payload_length, __uint8_t *response)
+{
+    (void)port;
+    const int count = payload_length < 1 ? -1 : sequencer_load(&sequencer, payload[0], &payload[1], payload_length - 1);
+    response[0] = count < 0 ? 0 : (__uint8_t)count;
+    return 1;
+}
+
+/**
+ * @brief Command handler for OPCODE_SEQUENCE_CONTROL.
+ * 
+ * Payload is SEQUENCE_STOP, SEQUENCE_PLAY or SEQUENCE_LOOP. Playback starts
+ * from the current color. Responds with 1 on success, 0 otherwise.
+ */
+static size_t sequence_control_command(SerialPortHandler *port, const __uint8_t *payload, size_t payload_length, __uint8_t *response)
+{
+    (void)payload_length;
+    const uint8_t from[3] = {port->r, port->g, port->b};
+    response[0] = 1;
+    sequencer_stop(&sequencer);
+    switch (payload[0]) {
+    case SEQUENCE_STOP:
+        break;
+    case SEQUENCE_PLAY:
+    case SEQUENCE_LOOP:
+        // Playback owns the PWM outputs, stop a fade in progress
+        pwm_output_set_rgb(gamma_table[from[0]], gamma_table[from[1]], gamma_table[from[2]]);
+        if (sequencer_play(&sequencer, payload[0] == SEQUENCE_LOOP, from) != 0) {
+            response[0] = 0;
+            break;
+        }
+        sequencer_ms = ms_ticks;
+        request_task(sequencer_task_id);
+        break;
+    default:
+        response[0] = 0;
+        break;
+    }
+    return 1;
+}
+
+/**
+ * @brief Command handler for OPCODE_GET_UPDATE_PERIOD.
+ * 
+ * Responds with the number of the PWM period in which the last color update
+ * took effect, followed by the number of the current period, both 4 bytes
+ * least significant byte first.
+ */
+static size_t get_update_period_command(SerialPortHandler *port, const __uint8_t *payload, size_t payload_length, __uint8_t *response)
+{
+    (void)port;
+    (void)payload;
+    (void)payload_length;
+    const uint32_t periods[2] = {pwm_output_update_period(), pwm_output_period_count()};
+    for (int i = 0; i < 2; ++i) {
+        response[4 * i] = (__uint8_t)periods[i];
+        response[4 * i + 1] = (__uint8_t)(periods[i] >> 8);
+        response[4 * i + 2] = (__uint8_t)(periods[i] >> 16);
+        response[4 * i + 3] = (__uint8_t)(periods[i] >> 24);
+    }
+    return 8;
+}
+
+/**
+ * @brief Command handler for OPCODE_SET_PWM_FREQUENCY.
+ * 
+ * Sets the PWM frequency of all channels to the value in the payload in Hz,
+ * 4 bytes least significant byte first, keeping the duty cycles. Responds
+ * with 1 if the frequency was set, 0 if it is out of range.
+ */
+static size_t set_pwm_frequency_command(SerialPortHandler *port, const __uint8_t *payload, size_t payload_length, __uint8_t *response)
+{
+    (void)port;
+    (void)payload_length;
+    const uint32_t hz = (uint32_t)payload[0] | ((uint32_t)payload[1] << 8) |
+                        ((uint32_t)payload[2] << 16) | ((uint32_t)payload[3] << 24);
+    response[0] = pwm_output_set_frequency(hz) == 0 ? 1 : 0;
+    request_phases();
+    return 1;
+}
+
+/**
+ * @brief Command handler for OPCODE_SET_CHANNEL_COUNT.
+ * 
+ * Enables the outputs of the first channels up to the count in the payload
+ * and holds the rest low. Responds with 1 on success, 0 if the count is out
+ * of range.
+ */
+static size_t set_channel_count_command(SerialPortHandler *port, const __uint8_t *payload, size_t payload_length, __uint8_t *response)
+{
+    (void)port;
+    (void)payload_length;
+    response[0] = pwm_output_set_channel_count(payload[0]) == 0 ? 1 : 0;
+    request_phases();
+    return 1;
+}
+
+/**
+ * @brief Command handler for OPCODE_SET_PHASE_STAGGER.
+ * 
+ * Payload 1 spreads the generators of the enabled channels over the PWM
+ * period, 0 aligns them. Responds with 1.
+ */
+static size_t set_phase_stagger_command(SerialPortHandler *port, const __uint8_t *payload, size_t payload_length, __uint8_t *response)
+{
+    (void)port;
+    (void)payload_length;
+    pwm_output_set_stagger(payload[0] != 0);
+    request_phases();
+    response[0] = 1;
+    return 1;
+}
+
+/**
+ * @brief Command handler for OPCODE_SET_BRIGHTNESS.
+ * 
+ * Scales all channels by the master brightness in payload bytes 0..1, least
+ * significant byte first, 0xFFFF being full brightness. Responds with 1.
+ */
+static size_t set_brightness_command(SerialPortHandler *port, const __uint8_t *payload, size_t payload_length, __uint8_t *response)
+{
+    (void)port;
+    (void)payload_length;
+    const uint32_t brightness = (uint32_t)payload[0] | ((uint32_t)payload[1] << 8);
+    // 0xFFFF maps to 1.0 in 16.16 fixed point
+    pwm_output_set_brightness(brightness + (brightness >> 15));
+    response[0] = 1;
+    return 1;
+}
+
+/**
+ * @brief Command handler for OPCODE_SET_POWER_BUDGET.
+ * 
+ * Limits the total duty cycle of the enabled channels to the budget in
+ * payload bytes 0..1, least significant byte first, in percent of one
+ * channel fully on. 0 removes the limit. Responds with 1.
+ */
+static size_t set_power_budget_command(SerialPortHandler *port, const __uint8_t *payload, size_t payload_length, __uint8_t *response)
+{
+    (void)port;
+    (void)payload_length;
+    const uint32_t percent = (uint32_t)payload[0] | ((uint32_t)payload[1] << 8);
+    pwm_output_set_power_budget(percent);
+    response[0] = 1;
+    return 1;
+}
+
+/**
+ * @brief Command handler for OPCODE_FADE.
+ * 
+ * Fades the LED to the color in payload bytes 0..2 over the duration in
+ * milliseconds in bytes 3..4, least significant byte first. The fade is
+ * stepped by the PWM interrupt, so it needs no further commands.
+ */
+static size_t fade_command(SerialPortHandler *port, const __uint8_t *payload, size_t payload_length, __uint8_t *response)
+{
+    (void)payload_length;
+    const uint32_t duration_ms = (uint32_t)payload[3] | ((uint32_t)payload[4] << 8);
+    sequencer_stop(&sequencer);
+    port->r = payload[0];
+    port->g = payload[1];
+    port->b = payload[2];
+    pwm_output_fade_rgb(gamma_table[port->r], gamma_table[port->g], gamma_table[port->b], duration_ms);
+    response[0] = 1;
+    return 1;
+}
+
+/**
+ * @brief Command handler for OPCODE_UPLOAD_WAVEFORM.
+ * 
+ * Payload byte 0 is the index of the first sample, followed by samples of
+ * r, g and b. The samples are gamma corrected and stored as compare values.
+ * Stops a playing waveform. Responds with the number of samples in the
+ * waveform, or 0 if the upload was rejected.
+ */
+static size_t upload_waveform_command(SerialPortHandler *port, const __uint8_t *payload, size_t payload_length, __uint8_t *response)
+{
+    (void)port;
+    int length = -1;
+    if (payload_length > 1 && (payload_length - 1) % 3 == 0) {
+        for (size_t i = 1; i < payload_length; i += 3) {
+            length = pwm_output_waveform_set(payload[0] + (unsigned int)(i / 3), gamma_table[payload[i]],
+                                             gamma_table[payload[i + 1]], gamma_table[payload[i + 2]]);
+            if (length < 0) {
+                break;
+            }
+        }
+    }
+    response[0] = length < 0 ? 0 : (__uint8_t)length;
+    return 1;
+}
+
+/**
+ * @brief Command handler for OPCODE_PLAY_WAVEFORM.
+ * 
+ * Loops the waveform by uDMA, holding each sample for the number of PWM
+ * periods in the payload (2 bytes, LSB first); 0 stops playback. Responds
+ * with 1 on success, 0 otherwise.
+ */
+static size_t play_waveform_command(SerialPortHandler *port, const __uint8_t *payload, size_t payload_length, __uint8_t *response)
+{
+    (void)port;
+    (void)payload_length;
+    const uint32_t hold_periods = (uint32_t)payload[0] | ((uint32_t)payload[1] << 8);
+    sequencer_stop(&sequencer);
+    if (hold_periods == 0) {
+        pwm_output_waveform_stop();
+        response[0] = 1;
+    } else {
+        response[0] = pwm_output_waveform_play(hold_periods) == 0 ? 1 : 0;
+    }
+    return 1;
 }
 
 /**
  * @brief Sends a character to the UART.
  * 
- * This function sends a character to the UART.
+ * The character is appended to the TX ring and the transmit FIFO is primed,
+ * after which the UART TX interrupt keeps the FIFO filled. If the ring is
+ * full, the FIFO is filled directly until there is space again.
  * 
  * @param c The character to send.
  */
 void uart_send_handler(unsigned char c)
 {
-    UARTCharPut(UART1_BASE, c);
+    int queued;
+    do {
+        queued = (ring_buffer_put(&tx_ring, c) == 0);
+
+        // Prime the FIFO, the TX interrupt only fires when the FIFO level drops
+        UARTIntDisable(UART1_BASE, UART_INT_TX);
+        uart_tx_fill();
+        UARTIntEnable(UART1_BASE, UART_INT_TX);
+    } while (!queued);
 }
 
+#if UART_TX_DMA
+/**
+ * @brief Sends a whole frame to the UART.
+ * 
+ * The frame is copied to the TX ring and sent by uDMA, one transfer per
+ * contiguous run in the ring. Only waits if the ring is full.
+ * 
+ * @param frame Pointer to the encoded frame.
+ * @param length Length of the frame.
+ */
+static void uart_send_frame(const __uint8_t *frame, size_t length)
+{
+    size_t written = 0;
+    while (written < length) {
+        written += ring_buffer_write(&tx_ring, &frame[written], length - written);
+
+        IntDisable(INT_UART1);
+        uart_tx_dma_service();
+        IntEnable(INT_UART1);
+    }
+}
+#endif
+
 /**
  * @brief Main function.
  * 
@@ -103,21 +1121,24 @@ void uart_send_handler(unsigned char c)
  */
 int main(void) {
     // Set system clock to 50 MHz
-    SysCtlClockSet(SYSCTL_SYSDIV_4 | SYSCTL_USE_PLL | SYSCTL_OSC_MAIN | SYSCTL_XTAL_16MHZ);
+    SysCtlClockSet(clock_presets[CPU_CLOCK_50MHZ].config);
+
+#if PROFILE
+    // Start the cycle counter of the profiled regions
+    profile_init();
+#endif
 
     // Set PWM clock divider to 1
     SysCtlPWMClockSet(SYSCTL_PWMDIV_1);
 
-    // Enable clock for Port F & wait for it to be ready
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOF);
-    while (!SysCtlPeripheralReady(SYSCTL_PERIPH_GPIOF));
-
     // Enable the UART1 peripheral
     SysCtlPeripheralEnable(SYSCTL_PERIPH_UART1);
+    SysCtlPeripheralSleepEnable(SYSCTL_PERIPH_UART1);
     while (!SysCtlPeripheralReady(SYSCTL_PERIPH_UART1));
 
     // Enable the Port B for UART1
     SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOB);
+    SysCtlPeripheralSleepEnable(SYSCTL_PERIPH_GPIOB);
     while (!SysCtlPeripheralReady(SYSCTL_PERIPH_GPIOB));
 
     // Configure UART1 pins
@@ -126,41 +1147,98 @@ int main(void) {
     GPIOPinTypeUART(GPIO_PORTB_BASE, GPIO_PIN_0 | GPIO_PIN_1);
 
     // Configure UART1
-    UARTConfigSetExpClk(UART1_BASE, SysCtlClockGet(), BAUD_RATE, (UART_CONFIG_WLEN_8 | UART_CONFIG_STOP_ONE | UART_CONFIG_PAR_NONE));
-
-    // Enable the PWM1 peripheral that can drive the LED pins
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_PWM1);
-    while (!SysCtlPeripheralReady(SYSCTL_PERIPH_PWM1));
-
-    // Configure the GPIO pad for PWM function on pins PF1, PF3 and PF2.
-    GPIOPinConfigure(GPIO_PF1_M1PWM5); //R
-    GPIOPinConfigure(GPIO_PF3_M1PWM7); //G 
-    GPIOPinConfigure(GPIO_PF2_M1PWM6); //B
-    GPIOPinTypePWM(GPIO_PORTF_BASE, GPIO_PIN_1);
-    GPIOPinTypePWM(GPIO_PORTF_BASE, GPIO_PIN_3);
-    GPIOPinTypePWM(GPIO_PORTF_BASE, GPIO_PIN_2);
-
-    // Configure the PWM1 to generate a PWM signal
-    // PWM_GEN_2 for output 5
-    // PWM_GEN_3 for outputs 6,7
-    PWMGenConfigure(PWM1_BASE, PWM_GEN_2, PWM_GEN_MODE_UP_DOWN | PWM_GEN_MODE_NO_SYNC);
-    PWMGenConfigure(PWM1_BASE, PWM_GEN_3, PWM_GEN_MODE_UP_DOWN | PWM_GEN_MODE_NO_SYNC);
-    PWMGenPeriodSet(PWM1_BASE, PWM_GEN_2, 100); // Set period to 100, means 500 Hz PWM signal
-    PWMGenPeriodSet(PWM1_BASE, PWM_GEN_3, 100); // Set period to 100, means 500 Hz PWM signal
-    PWMPulseWidthSet(PWM1_BASE, LED_R_PWM_OUT, 0); // 0% duty cycle
-    PWMPulseWidthSet(PWM1_BASE, LED_G_PWM_OUT, 0); // 0% duty cycle
-    PWMPulseWidthSet(PWM1_BASE, LED_B_PWM_OUT, 0); // 0% duty cycle
-    PWMOutputState(PWM1_BASE, PWM_OUT_5_BIT | PWM_OUT_7_BIT | PWM_OUT_6_BIT, true);
-    PWMGenEnable(PWM1_BASE, PWM_GEN_2);
-    PWMGenEnable(PWM1_BASE, PWM_GEN_3);
+    UARTConfigSetExpClk(UART1_BASE, SysCtlClockGet(), baud_rate, UART_CONFIG);
+
+    // TX interrupt when the transmit FIFO drops to 2/8 full, RX interrupt at 4/8 full
+    UARTTxIntModeSet(UART1_BASE, UART_TXINT_MODE_FIFO);
+    UARTFIFOLevelSet(UART1_BASE, UART_FIFO_TX2_8, UART_FIFO_RX4_8);
+    ring_buffer_init(&tx_ring);
+
+    // Configure the PWM outputs for the LED
+    pwm_output_init();
+
+    // Commands run below all other interrupts. pwm_output_init() has set the
+    // priority of the PWM and waveform timer interrupts.
+    IntPrioritySet(INT_UART1, UART_INT_PRIORITY);
+    IntPrioritySet(FAULT_SYSTICK, SYSTICK_INT_PRIORITY);
+    IntPrioritySet(FAULT_PENDSV, PENDSV_INT_PRIORITY);
+
+    // Start the 1 ms SysTick time base
+    SysTickPeriodSet(SysCtlClockGet() / SYSTICK_HZ);
+    SysTickIntEnable();
+    SysTickEnable();
+
+    // Count system clock cycles for the load statistics
+    SysCtlPeripheralEnable(LOAD_TIMER_PERIPH);
+    SysCtlPeripheralSleepEnable(LOAD_TIMER_PERIPH);
+    while (!SysCtlPeripheralReady(LOAD_TIMER_PERIPH));
+    TimerConfigure(LOAD_TIMER_BASE, TIMER_CFG_PERIODIC);
+    TimerLoadSet(LOAD_TIMER_BASE, TIMER_A, 0xFFFFFFFF);
+    TimerEnable(LOAD_TIMER_BASE, TIMER_A);
+
+    // Enable the uDMA controller
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_UDMA);
+    SysCtlPeripheralSleepEnable(SYSCTL_PERIPH_UDMA);
+    while (!SysCtlPeripheralReady(SYSCTL_PERIPH_UDMA));
+    uDMAEnable();
+    uDMAControlBaseSet(udma_control_table);
 
     // Init serial port handler
     init_serial_port_handler(&handler, led_pwm_handler, uart_send_handler);
+    sequencer_init(&sequencer, sequencer_output);
+#if UART_TX_DMA
+    uart_tx_dma_init();
+    serial_set_frame_sender(&handler, uart_send_frame);
+#endif
+    serial_enable_crc(&handler, SERIAL_CRC);
+    serial_register_command(&handler, OPCODE_SET_BAUD_RATE, set_baud_rate_command, 4, 1);
+    serial_register_command(&handler, OPCODE_GET_UPDATE_PERIOD, get_update_period_command, 0, 8);
+    serial_register_command(&handler, OPCODE_FADE, fade_command, 5, 1);
+    serial_register_command(&handler, OPCODE_UPLOAD_SEQUENCE, upload_sequence_command, PAYLOAD_LENGTH_VARIABLE, 1);
+    serial_register_command(&handler, OPCODE_SEQUENCE_CONTROL, sequence_control_command, 1, 1);
+    serial_register_command(&handler, OPCODE_UPLOAD_WAVEFORM, upload_waveform_command, PAYLOAD_LENGTH_VARIABLE, 1);
+    serial_register_command(&handler, OPCODE_PLAY_WAVEFORM, play_waveform_command, 2, 1);
+    serial_register_command(&handler, OPCODE_SET_LED_COLOR16, set_led_color16_command, 6, 1);
+    serial_register_command(&handler, OPCODE_SET_CHANNELS, set_channels_command, PAYLOAD_LENGTH_VARIABLE, 1);
+    serial_register_command(&handler, OPCODE_SET_PWM_FREQUENCY, set_pwm_frequency_command, 4, 1);
+    serial_register_command(&handler, OPCODE_SET_CHANNEL_COUNT, set_channel_count_command, 1, 1);
+    serial_register_command(&handler, OPCODE_SET_PHASE_STAGGER, set_phase_stagger_command, 1, 1);
+    serial_register_command(&handler, OPCODE_SET_BRIGHTNESS, set_brightness_command, 2, 1);
+    serial_register_command(&handler, OPCODE_SET_POWER_BUDGET, set_power_budget_command, 2, 1);
+    serial_register_command(&handler, OPCODE_GET_LOAD, get_load_command, 0, 8);
+    serial_register_command(&handler, OPCODE_GET_TASK_STATS, get_task_stats_command, 1, 16);
+    serial_register_command(&handler, OPCODE_SET_CPU_CLOCK, set_cpu_clock_command, 1, 1);
+    serial_register_command(&handler, OPCODE_GET_PROFILE, get_profile_command, 1, 16 * PROFILE_REGIONS);
+    frame_queue_init(&frame_queue);
+    serial_set_frame_queue(&handler, &frame_queue);
 
-    // Enable UART1 interrupt to start receiving data
+    // Enable UART1 interrupt to start receiving data, TX is enabled when there is something to send
+#if UART_RX_DMA
+    uart_rx_dma_init();
+    IntEnable(INT_UART1);
+    UARTIntEnable(UART1_BASE, UART_INT_RT);
+#else
     IntEnable(INT_UART1);
     UARTIntEnable(UART1_BASE, UART_INT_RX | UART_INT_RT);
+#endif
+
+    // Only the peripherals enabled for sleep above keep their clocks in sleep
+    SysCtlPeripheralClockGating(true);
 
-    // Infinite loop
-    while (1) {    }
+    // Tasks, numbered in the order added
+    scheduler_init(&scheduler, scheduler_ticks, load_timer_cycles);
+    sequencer_task_id = scheduler_add(&scheduler, sequencer_task, 1, 1);
+    baud_rate_task_id = scheduler_add(&scheduler, baud_rate_service, 1, 1);
+    baud_rate_revert_task_id = scheduler_add(&scheduler, baud_rate_revert, SCHEDULER_ONE_SHOT, 1);
+    clock_task_id = scheduler_add(&scheduler, clock_service, 1, 1);
+    phase_task_id = scheduler_add(&scheduler, pwm_output_apply_phases, SCHEDULER_ONE_SHOT, 1);
+
+    // Infinite loop, executing the tasks released by SysTick and sleeping in
+    // between. Commands preempt the tasks from PendSV and request the tasks
+    // they need, so no task runs while there is nothing to do.
+    while (1) {
+        start_requested_tasks();
+        scheduler_run(&scheduler);
+        idle();
+    }
 }
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * Fixed-point output stage. All channels are multiplied by one scale: the
+ * master brightness, reduced when needed so that the total of the pulse
+ * widths stays within the budget. The reduction uses a reciprocal table
+ * instead of a division and always rounds down, so the budget is never
+ * exceeded.
+ */
+
+#include "output_stage.h"
+
+// Reciprocals 2^23 / (m + 1) of the normalized denominators m = 128..255
+#define RECIPROCAL(m) (uint16_t)(0x800000u / ((m) + 1u)),
+#define RECIPROCAL4(m) RECIPROCAL(m) RECIPROCAL((m) + 1) RECIPROCAL((m) + 2) RECIPROCAL((m) + 3)
+#define RECIPROCAL16(m) RECIPROCAL4(m) RECIPROCAL4((m) + 4) RECIPROCAL4((m) + 8) RECIPROCAL4((m) + 12)
+
+static const uint16_t reciprocals[128] = {
+    RECIPROCAL16(128) RECIPROCAL16(144) RECIPROCAL16(160) RECIPROCAL16(176)
+    RECIPROCAL16(192) RECIPROCAL16(208) RECIPROCAL16(224) RECIPROCAL16(240)
+};
+
+/**
+ * @brief Returns num / den in 16.16 fixed point, rounded down.
+ * 
+ * den is normalized to 8 significant bits m, and rounded up to m + 1 so the
+ * result is at most the exact quotient, within 1 %.
+ */
+static uint32_t output_stage_ratio(uint32_t num, uint32_t den) {
+    const int msb = 31 - __builtin_clz(den);
+    const int shift = msb - 7;
+    const uint32_t m = shift >= 0 ? den >> shift : den << -shift;
+    return (uint32_t)(((uint64_t)num * reciprocals[m - 128]) >> (7 + shift));
+}
+
+/**
+ * @brief Initializes the output stage to full brightness and no budget.
+ * 
+ * @param stage Pointer to the OutputStage structure to initialize.
+ */
+void output_stage_init(OutputStage *stage) {
+    stage->brightness = OUTPUT_STAGE_ONE;
+    stage->budget = OUTPUT_STAGE_NO_BUDGET;
+}
+
+/**
+ * @brief Sets the master brightness.
+ * 
+ * @param stage Pointer to the OutputStage structure.
+ * @param brightness The brightness in 16.16 fixed point, limited to 1.0.
+ */
+void output_stage_set_brightness(OutputStage *stage, uint32_t brightness) {
+    stage->brightness = brightness > OUTPUT_STAGE_ONE ? OUTPUT_STAGE_ONE : brightness;
+}
+
+/**
+ * @brief Sets the largest total of the scaled pulse widths.
+ * 
+ * @param stage Pointer to the OutputStage structure.
+ * @param budget The budget, or OUTPUT_STAGE_NO_BUDGET.
+ */
+void output_stage_set_budget(OutputStage *stage, uint32_t budget) {
+    stage->budget = budget;
+}
+
+/**
+ * @brief Returns the scale of all channels for a total of pulse widths.
+ * 
+ * The scale is the master brightness, unless the scaled total would exceed
+ * the budget, in which case every channel is scaled down proportionally to
+ * fit it. No division is done.
+ * 
+ * @param stage Pointer to the OutputStage structure.
+ * @param total The total of the unscaled pulse widths of all channels.
+ * @return The scale in 16.16 fixed point.
+ */
+uint32_t output_stage_scale(const OutputStage *stage, uint32_t total) {
+    if (total == 0 || (((uint64_t)total * stage->brightness) >> 16) <= stage->budget) {
+        return stage->brightness;
+    }
+    return output_stage_ratio(stage->budget, total);
+}
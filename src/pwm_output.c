@@ -0,0 +1,1059 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * PWM output driver for up to 16 channels on PWM0 and PWM1. Channels 0..2
+ * are the RGB LED of the LaunchPad.
+ * 
+ * The channels are described by a table of generator, output and pin-mux
+ * entries that is configured at init. The generators in use run with a
+ * common time base in globally synchronized mode: new compare values are
+ * written to the shadow registers and committed together by PWMSyncUpdate()
+ * at the start of the next PWM period, so a period never shows a mix of the
+ * old and the new color.
+ * 
+ * Callers give pulse widths relative to the nominal period PWM_PERIOD, the
+ * period of the gamma table. The PWM frequency can be changed at runtime;
+ * the widths are then scaled to the actual period with a fixed-point
+ * multiplication when written.
+ * 
+ * In staggered mode, the generators in use are started at evenly spread
+ * offsets of the period instead of together, so the channels of different
+ * generators do not switch on at the same time.
+ * 
+ * In waveform mode, a table of compare values is moved into the compare
+ * registers by uDMA. The PWM module has no uDMA request of its own, so each
+ * compare register is fed by a uDMA channel triggered by a general-purpose
+ * timer running at a multiple of the PWM period, aligned to the middle of
+ * the period.
+ */
+
+// Standard libraries
+#include <stdint.h>
+#include <stdbool.h>
+
+// TivaWare driver libraries
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "inc/hw_ints.h"
+#include "inc/hw_pwm.h"
+#include "inc/hw_gpio.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/cpu.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/gpio.h"
+#include "driverlib/pin_map.h"
+#include "driverlib/pwm.h"
+#include "driverlib/timer.h"
+#include "driverlib/udma.h"
+
+// User libraries
+#include "pwm_output.h"
+#include "fade.h"
+#include "dither.h"
+#include "output_stage.h"
+#include "profile.h"
+
+// PWM configuration
+#ifndef PWM_DITHER
+#define PWM_DITHER 1                                // Dither fractional pulse widths over periods
+#endif
+#ifndef PWM_PERIOD
+#define PWM_PERIOD 10000                            // PWM clock cycles per period, 5 kHz at 50 MHz
+#endif
+#if PWM_PERIOD < 2 || PWM_PERIOD > 65535
+#error "PWM_PERIOD must fit the 16-bit gamma table"
+#endif
+#define PWM_MIN_PERIOD 256                          // Shortest runtime period, for 8-bit resolution
+#define PWM_MAX_PERIOD 65535                        // Longest runtime period, for 16-bit widths
+#define PWM_GEN_SYNC_PENDING (PWM_CTL_GLOBALSYNC0 | PWM_CTL_GLOBALSYNC1 | PWM_CTL_GLOBALSYNC2 | PWM_CTL_GLOBALSYNC3)
+#define PERIOD_TIMER_PERIPH SYSCTL_PERIPH_WTIMER0       // Time base of the period count
+#define PERIOD_TIMER_BASE WTIMER0_BASE
+
+// Channel map
+typedef struct {
+    uint32_t pwm_base;
+    uint32_t gen;
+    uint32_t out;
+    uint32_t out_bit;
+    uint32_t gpio_periph;
+    uint32_t gpio_base;
+    uint8_t gpio_pin;
+    uint32_t pin_config;
+} PwmChannel;
+
+// On the LaunchPad, PD0/PD1 are connected to PB6/PB7 through R9/R10, which
+// must be removed to use channels 4, 5, 14 and 15 together. PF0 is the SW2
+// pin, unlocked at init. Only the channels below PWM_CHANNEL_COUNT are
+// configured, the LED ones by default.
+static const PwmChannel pwm_channels[PWM_MAX_CHANNELS] = {
+    {PWM1_BASE, PWM_GEN_2, PWM_OUT_5, PWM_OUT_5_BIT, SYSCTL_PERIPH_GPIOF, GPIO_PORTF_BASE, GPIO_PIN_1, GPIO_PF1_M1PWM5}, // LED red
+    {PWM1_BASE, PWM_GEN_3, PWM_OUT_7, PWM_OUT_7_BIT, SYSCTL_PERIPH_GPIOF, GPIO_PORTF_BASE, GPIO_PIN_3, GPIO_PF3_M1PWM7}, // LED green
+    {PWM1_BASE, PWM_GEN_3, PWM_OUT_6, PWM_OUT_6_BIT, SYSCTL_PERIPH_GPIOF, GPIO_PORTF_BASE, GPIO_PIN_2, GPIO_PF2_M1PWM6}, // LED blue
+    {PWM1_BASE, PWM_GEN_2, PWM_OUT_4, PWM_OUT_4_BIT, SYSCTL_PERIPH_GPIOF, GPIO_PORTF_BASE, GPIO_PIN_0, GPIO_PF0_M1PWM4},
+    {PWM0_BASE, PWM_GEN_0, PWM_OUT_0, PWM_OUT_0_BIT, SYSCTL_PERIPH_GPIOB, GPIO_PORTB_BASE, GPIO_PIN_6, GPIO_PB6_M0PWM0},
+    {PWM0_BASE, PWM_GEN_0, PWM_OUT_1, PWM_OUT_1_BIT, SYSCTL_PERIPH_GPIOB, GPIO_PORTB_BASE, GPIO_PIN_7, GPIO_PB7_M0PWM1},
+    {PWM0_BASE, PWM_GEN_1, PWM_OUT_2, PWM_OUT_2_BIT, SYSCTL_PERIPH_GPIOB, GPIO_PORTB_BASE, GPIO_PIN_4, GPIO_PB4_M0PWM2},
+    {PWM0_BASE, PWM_GEN_1, PWM_OUT_3, PWM_OUT_3_BIT, SYSCTL_PERIPH_GPIOB, GPIO_PORTB_BASE, GPIO_PIN_5, GPIO_PB5_M0PWM3},
+    {PWM0_BASE, PWM_GEN_2, PWM_OUT_4, PWM_OUT_4_BIT, SYSCTL_PERIPH_GPIOE, GPIO_PORTE_BASE, GPIO_PIN_4, GPIO_PE4_M0PWM4},
+    {PWM0_BASE, PWM_GEN_2, PWM_OUT_5, PWM_OUT_5_BIT, SYSCTL_PERIPH_GPIOE, GPIO_PORTE_BASE, GPIO_PIN_5, GPIO_PE5_M0PWM5},
+    {PWM0_BASE, PWM_GEN_3, PWM_OUT_6, PWM_OUT_6_BIT, SYSCTL_PERIPH_GPIOC, GPIO_PORTC_BASE, GPIO_PIN_4, GPIO_PC4_M0PWM6},
+    {PWM0_BASE, PWM_GEN_3, PWM_OUT_7, PWM_OUT_7_BIT, SYSCTL_PERIPH_GPIOC, GPIO_PORTC_BASE, GPIO_PIN_5, GPIO_PC5_M0PWM7},
+    {PWM1_BASE, PWM_GEN_1, PWM_OUT_2, PWM_OUT_2_BIT, SYSCTL_PERIPH_GPIOA, GPIO_PORTA_BASE, GPIO_PIN_6, GPIO_PA6_M1PWM2},
+    {PWM1_BASE, PWM_GEN_1, PWM_OUT_3, PWM_OUT_3_BIT, SYSCTL_PERIPH_GPIOA, GPIO_PORTA_BASE, GPIO_PIN_7, GPIO_PA7_M1PWM3},
+    {PWM1_BASE, PWM_GEN_0, PWM_OUT_0, PWM_OUT_0_BIT, SYSCTL_PERIPH_GPIOD, GPIO_PORTD_BASE, GPIO_PIN_0, GPIO_PD0_M1PWM0},
+    {PWM1_BASE, PWM_GEN_0, PWM_OUT_1, PWM_OUT_1_BIT, SYSCTL_PERIPH_GPIOD, GPIO_PORTD_BASE, GPIO_PIN_1, GPIO_PD1_M1PWM1},
+};
+
+// Generators of a module in use, with their bit-wise IDs
+#define PWM_MODULES 2
+static const uint32_t pwm_bases[PWM_MODULES] = {PWM0_BASE, PWM1_BASE};
+static const uint32_t pwm_periphs[PWM_MODULES] = {SYSCTL_PERIPH_PWM0, SYSCTL_PERIPH_PWM1};
+static uint32_t pwm_gen_bits[PWM_MODULES];
+static uint32_t pwm_out_bits[PWM_MODULES];
+
+// PWM clock dividers, the divider at index d divides by 2^d
+static const uint32_t pwm_dividers[] = {
+    SYSCTL_PWMDIV_1, SYSCTL_PWMDIV_2, SYSCTL_PWMDIV_4, SYSCTL_PWMDIV_8,
+    SYSCTL_PWMDIV_16, SYSCTL_PWMDIV_32, SYSCTL_PWMDIV_64
+};
+
+// Channels with their outputs enabled, and whether their generators are staggered
+static unsigned int channel_count = PWM_CHANNEL_COUNT;
+static bool stagger;
+
+// Set when the generators have to be restarted with new phase offsets
+static volatile bool phases_pending;
+
+// Waveform playback on the LED channels, one timer and uDMA channel per compare register
+typedef struct {
+    uint32_t timer_base;
+    uint32_t dma_assignment;
+    uint32_t dma_channel;
+} WaveformChannel;
+
+static const WaveformChannel waveform_channels[PWM_LED_CHANNELS] = {
+    {TIMER0_BASE, UDMA_CH18_TIMER0A, UDMA_CHANNEL_TMR0A},
+    {TIMER1_BASE, UDMA_CH20_TIMER1A, UDMA_CHANNEL_TMR1A},
+    {TIMER2_BASE, UDMA_CH4_TIMER2A, UDMA_SEC_CHANNEL_TMR2A_4},
+};
+#define WAVEFORM_TIMER_SYNC (TIMER_0A_SYNC | TIMER_1A_SYNC | TIMER_2A_SYNC)
+
+// The periods are counted from a free-running 64-bit timer at the system
+// clock rather than an interrupt per period: the period numbered
+// period_base started at period_base_time, and each lasts period_cycles
+// system clock cycles. A period keeps its length in system clock cycles
+// across a clock switch, as the PWM clock is divided from it. When the
+// length or the phase changes, the next counter zero re-anchors the count.
+static uint64_t period_base_time;
+static uint32_t period_base;
+static uint32_t period_cycles;
+static uint32_t next_period_cycles;
+static volatile bool rebase_pending;
+
+// Period in which the last committed update took effect
+static volatile uint32_t update_period;
+static volatile bool update_pending;
+
+// Enabled outputs held low until a new PWM clock divider and the period
+// for it have both taken effect
+static volatile bool outputs_held;
+
+// Pulse widths last written to the channels, relative to PWM_PERIOD
+static uint32_t widths[PWM_CHANNEL_COUNT];
+
+// Actual period in PWM clock cycles, and the scale of the widths to it in
+// 16.16 fixed point
+static uint32_t period = PWM_PERIOD;
+static uint32_t width_scale = 1u << 16;
+
+// Master brightness and power budget, the total of the enabled channels'
+// widths, and the scale last applied by the stage
+static OutputStage stage;
+static uint32_t total;
+static uint32_t stage_scale = OUTPUT_STAGE_ONE;
+
+// Combined scale of width_scale and stage_scale, 16.16 fixed point
+static uint32_t output_scale = 1u << 16;
+
+// Fade in progress, stepped from the counter load interrupt
+static Fade fade;
+
+// Fractional widths being dithered from the counter load interrupt
+static Dither dither;
+
+// Compare values of the waveform, per channel
+static uint32_t waveform[PWM_LED_CHANNELS][PWM_WAVEFORM_MAX_SAMPLES];
+static unsigned int waveform_length;
+static volatile bool waveform_playing;
+static volatile bool waveform_start_pending;
+
+/**
+ * @brief Returns the PWM clock frequency in Hz.
+ */
+static uint32_t pwm_output_clock(void)
+{
+    const uint32_t config = SysCtlPWMClockGet();
+    if (config == SYSCTL_PWMDIV_1) {
+        return SysCtlClockGet();
+    }
+    // The divider field n selects a division by 2^(n + 1)
+    return SysCtlClockGet() >> (((config >> 17) & 0x7) + 1);
+}
+
+/**
+ * @brief Returns the address of a register of the generator of a channel.
+ */
+static uintptr_t pwm_output_gen_register(const PwmChannel *channel, uint32_t offset)
+{
+    return (uintptr_t)channel->pwm_base + channel->gen + offset;
+}
+
+/**
+ * @brief Returns the address of the compare register driving a channel.
+ */
+static uintptr_t pwm_output_compare(const PwmChannel *channel)
+{
+    return pwm_output_gen_register(channel, (channel->out & 1) ? PWM_O_X_CMPB : PWM_O_X_CMPA);
+}
+
+/**
+ * @brief Returns the update mode bit of the compare register of a channel.
+ */
+static uint32_t pwm_output_compare_update_bit(const PwmChannel *channel)
+{
+    return (channel->out & 1) ? PWM_X_CTL_CMPBUPD : PWM_X_CTL_CMPAUPD;
+}
+
+/**
+ * @brief Scales a pulse width relative to PWM_PERIOD to the actual period,
+ * with the brightness and power budget applied.
+ */
+static inline uint32_t pwm_output_scale(uint32_t width)
+{
+    return (uint32_t)(((uint64_t)width * output_scale) >> 16);
+}
+
+/**
+ * @brief Returns the system clock cycles elapsed on the period time base.
+ */
+static inline uint64_t pwm_output_time(void)
+{
+    // The timer counts down from its full range
+    return ~TimerValueGet64(PERIOD_TIMER_BASE);
+}
+
+/**
+ * @brief Enables the counter zero interrupt of the LED generator, if not on
+ * yet, before an update or re-anchoring is requested.
+ * 
+ * Must be called with the PWM interrupt masked.
+ */
+static void pwm_output_watch_zero(void)
+{
+    if (!update_pending && !rebase_pending) {
+        // A zero latched while the trigger was off is stale
+        PWMGenIntClear(PWM1_BASE, PWM_GEN_3, PWM_INT_CNT_ZERO);
+        PWMGenIntTrigEnable(PWM1_BASE, PWM_GEN_3, PWM_INT_CNT_ZERO);
+    }
+}
+
+/**
+ * @brief Holds the enabled outputs low, or releases them, at once instead of
+ * at the next global synchronization.
+ * 
+ * Must be called with the PWM interrupt masked.
+ */
+static void pwm_output_hold(bool hold)
+{
+    for (unsigned int i = 0; i < channel_count; ++i) {
+        const PwmChannel *channel = &pwm_channels[i];
+        PWMOutputUpdateMode(channel->pwm_base, channel->out_bit, PWM_OUTPUT_MODE_NO_SYNC);
+        PWMOutputState(channel->pwm_base, channel->out_bit, !hold);
+        PWMOutputUpdateMode(channel->pwm_base, channel->out_bit, PWM_OUTPUT_MODE_SYNC_GLOBAL);
+    }
+    outputs_held = hold;
+}
+
+/**
+ * @brief Writes the pulse widths of a range of channels and requests a
+ * synchronized update.
+ * 
+ * The running total of the widths gives the output stage scale. If the
+ * scale changes, all channels are rewritten with it, otherwise only the
+ * range. A count of 0 just reapplies the stage.
+ */
+static void pwm_output_write(unsigned int first, const uint32_t *values, unsigned int count)
+{
+    // The total is shared with the interrupts writing the LED channels
+    const uint32_t basepri = CPUbasepriGet();
+    CPUbasepriSet(PWM_OUTPUT_INT_PRIORITY);
+    for (unsigned int i = 0; i < count; ++i) {
+        if (first + i < channel_count) {
+            total = total - widths[first + i] + values[i];
+        }
+        widths[first + i] = values[i];
+    }
+    const uint32_t scale = output_stage_scale(&stage, total);
+    if (scale != stage_scale) {
+        stage_scale = scale;
+        output_scale = (uint32_t)(((uint64_t)width_scale * scale) >> 16);
+        first = 0;
+        count = PWM_CHANNEL_COUNT;
+    }
+    for (unsigned int i = first; i < first + count; ++i) {
+        PWMPulseWidthSet(pwm_channels[i].pwm_base, pwm_channels[i].out, pwm_output_scale(widths[i]));
+    }
+    pwm_output_watch_zero();
+    update_pending = true;
+    for (unsigned int m = 0; m < PWM_MODULES; ++m) {
+        if (pwm_gen_bits[m] != 0) {
+            PWMSyncUpdate(pwm_bases[m], pwm_gen_bits[m]);
+        }
+    }
+    CPUbasepriSet(basepri);
+}
+
+/**
+ * @brief PWM1 generator 3 interrupt handler.
+ * 
+ * While an update is pending, called at the start of the PWM period
+ * (counter zero) to record the period in which it was taken into use, or to
+ * re-anchor the period count after a change of the period length or phase.
+ * The zero interrupt is turned off again once neither is pending, so an idle
+ * output does not interrupt at all. While a fade runs, it is also called at
+ * the middle of the period (counter load) to step the fade; the new widths
+ * are committed at the next zero, so each step has half a period to
+ * complete. The load interrupt also dithers fractional widths and starts
+ * the waveform timers.
+ */
+void PWM1Gen3IntHandler(void) // cppcheck-suppress unusedFunction - this is defined in the ISR vector table
+{
+    PROFILE_BEGIN(start);
+    const uint32_t status = PWMGenIntStatus(PWM1_BASE, PWM_GEN_3, true);
+    PWMGenIntClear(PWM1_BASE, PWM_GEN_3, status);
+
+    if (status & PWM_INT_CNT_ZERO) {
+        // The interrupt latency is well below half a period, round to the nearest
+        const uint64_t now = pwm_output_time();
+        const uint32_t count = period_base + (uint32_t)((now - period_base_time + period_cycles / 2) / period_cycles);
+
+        // The sync request bits clear when the generators have taken the update
+        if (rebase_pending && (HWREG(PWM1_BASE + PWM_O_CTL) & PWM_CTL_GLOBALSYNC3) == 0) {
+            period_base = count;
+            period_base_time = now;
+            period_cycles = next_period_cycles;
+            rebase_pending = false;
+        }
+        if (update_pending && ((HWREG(PWM0_BASE + PWM_O_CTL) | HWREG(PWM1_BASE + PWM_O_CTL)) & PWM_GEN_SYNC_PENDING) == 0) {
+            update_period = count;
+            update_pending = false;
+            if (outputs_held) {
+                pwm_output_hold(false);
+            }
+        }
+        if (!rebase_pending && !update_pending) {
+            PWMGenIntTrigDisable(PWM1_BASE, PWM_GEN_3, PWM_INT_CNT_ZERO);
+        }
+    }
+
+    if ((status & PWM_INT_CNT_LOAD) && waveform_start_pending) {
+        // Start the waveform timers together, so they expire at the middle of a period
+        PWMGenIntTrigDisable(PWM1_BASE, PWM_GEN_3, PWM_INT_CNT_LOAD);
+        waveform_start_pending = false;
+        for (unsigned int i = 0; i < PWM_LED_CHANNELS; ++i) {
+            TimerEnable(waveform_channels[i].timer_base, TIMER_A);
+        }
+        TimerSynchronize(TIMER0_BASE, WAVEFORM_TIMER_SYNC);
+    } else if ((status & PWM_INT_CNT_LOAD) && dither_active(&dither)) {
+        uint32_t rgb[DITHER_CHANNELS];
+        dither_step(&dither, rgb);
+        pwm_output_write(0, rgb, DITHER_CHANNELS);
+    } else if (status & PWM_INT_CNT_LOAD) {
+        uint32_t rgb[FADE_CHANNELS];
+        if (!fade_step(&fade, rgb)) {
+            PWMGenIntTrigDisable(PWM1_BASE, PWM_GEN_3, PWM_INT_CNT_LOAD);
+        }
+        pwm_output_write(0, rgb, FADE_CHANNELS);
+    }
+    PROFILE_END(PROFILE_PWM_ISR, start);
+}
+
+/**
+ * @brief Stops the waveform playback, leaving the last compare values.
+ */
+void pwm_output_waveform_stop(void)
+{
+    if (!waveform_playing) {
+        return;
+    }
+    waveform_playing = false;
+    waveform_start_pending = false;
+    for (unsigned int i = 0; i < PWM_LED_CHANNELS; ++i) {
+        const PwmChannel *channel = &pwm_channels[i];
+        TimerDisable(waveform_channels[i].timer_base, TIMER_A);
+        uDMAChannelDisable(waveform_channels[i].dma_channel);
+
+        // Back to compare updates on global synchronization
+        HWREG(pwm_output_gen_register(channel, PWM_O_X_CTL)) |= pwm_output_compare_update_bit(channel);
+    }
+}
+
+/**
+ * @brief Stops everything that updates the widths from interrupts.
+ * 
+ * With the load trigger off, the PWM interrupt no longer touches the widths.
+ */
+static void pwm_output_take(void)
+{
+    PWMGenIntTrigDisable(PWM1_BASE, PWM_GEN_3, PWM_INT_CNT_LOAD);
+    fade_stop(&fade);
+    dither_stop(&dither);
+    pwm_output_waveform_stop();
+}
+
+/**
+ * @brief Sets the pulse widths of the RGB LED channels.
+ * 
+ * All three widths take effect together at the start of the next period.
+ * A fade or waveform in progress is stopped.
+ * 
+ * @param r The red pulse width relative to PWM_PERIOD.
+ * @param g The green pulse width relative to PWM_PERIOD.
+ * @param b The blue pulse width relative to PWM_PERIOD.
+ */
+void pwm_output_set_rgb(uint32_t r, uint32_t g, uint32_t b)
+{
+    const uint32_t rgb[PWM_LED_CHANNELS] = {r, g, b};
+
+    pwm_output_take();
+    pwm_output_write(0, rgb, PWM_LED_CHANNELS);
+}
+
+/**
+ * @brief Sets the pulse widths of a contiguous range of channels.
+ * 
+ * The widths take effect together at the start of the next period. If the
+ * range includes the RGB LED channels, a fade or waveform in progress is
+ * stopped.
+ * 
+ * @param first The first channel.
+ * @param values The pulse widths relative to PWM_PERIOD.
+ * @param count The number of channels.
+ * @return 0 on success, -1 if the range is not within PWM_CHANNEL_COUNT.
+ */
+int pwm_output_set_channels(unsigned int first, const uint32_t *values, unsigned int count)
+{
+    if (count == 0 || first >= PWM_CHANNEL_COUNT || count > PWM_CHANNEL_COUNT - first) {
+        return -1;
+    }
+    if (first < PWM_LED_CHANNELS) {
+        pwm_output_take();
+    }
+    pwm_output_write(first, values, count);
+    return 0;
+}
+
+/**
+ * @brief Sets fractional pulse widths of the RGB LED channels.
+ * 
+ * With PWM_DITHER, each period outputs one of the two nearest widths so that
+ * the average over consecutive periods is the fractional width. Otherwise
+ * the widths are rounded. A fade or waveform in progress is stopped.
+ * 
+ * @param r The red pulse width relative to PWM_PERIOD, in 1/256.
+ * @param g The green pulse width relative to PWM_PERIOD, in 1/256.
+ * @param b The blue pulse width relative to PWM_PERIOD, in 1/256.
+ */
+void pwm_output_set_rgb_fine(uint32_t r, uint32_t g, uint32_t b)
+{
+    const uint32_t target[DITHER_CHANNELS] = {r, g, b};
+    uint32_t rgb[DITHER_CHANNELS];
+
+    pwm_output_take();
+    dither_start(&dither, target);
+    dither_step(&dither, rgb);
+    pwm_output_write(0, rgb, DITHER_CHANNELS);
+#if PWM_DITHER
+    if (dither_active(&dither)) {
+        PWMGenIntClear(PWM1_BASE, PWM_GEN_3, PWM_INT_CNT_LOAD);
+        PWMGenIntTrigEnable(PWM1_BASE, PWM_GEN_3, PWM_INT_CNT_LOAD);
+    }
+#else
+    // Without dithering, the first step (the rounded width) is kept
+    dither_stop(&dither);
+#endif
+}
+
+
+/**
+ * @brief Fades the RGB LED channels from their current pulse widths.
+ * 
+ * The widths are stepped once per PWM period, so the fade takes
+ * duration_ms milliseconds with no further commands. A fade in progress is
+ * replaced, starting from where it was. A waveform in progress is stopped.
+ * 
+ * @param r The red target pulse width relative to PWM_PERIOD.
+ * @param g The green target pulse width relative to PWM_PERIOD.
+ * @param b The blue target pulse width relative to PWM_PERIOD.
+ * @param duration_ms The duration of the fade in milliseconds.
+ */
+void pwm_output_fade_rgb(uint32_t r, uint32_t g, uint32_t b, uint32_t duration_ms)
+{
+    const uint32_t target[FADE_CHANNELS] = {r, g, b};
+    const uint32_t steps = (uint32_t)(((uint64_t)duration_ms * (pwm_output_clock() / period)) / 1000);
+
+    pwm_output_take();
+    PWMGenIntClear(PWM1_BASE, PWM_GEN_3, PWM_INT_CNT_LOAD);
+    fade_start(&fade, widths, target, steps);
+    PWMGenIntTrigEnable(PWM1_BASE, PWM_GEN_3, PWM_INT_CNT_LOAD);
+}
+
+/**
+ * @brief Stores a sample of the waveform, stopping playback.
+ * 
+ * The pulse widths are converted to compare values when stored. The
+ * waveform ends after the last sample stored, so index 0 starts a new
+ * waveform and the index equal to the length appends to it.
+ * 
+ * @param index The sample index, at most the current length.
+ * @param r The red pulse width relative to PWM_PERIOD.
+ * @param g The green pulse width relative to PWM_PERIOD.
+ * @param b The blue pulse width relative to PWM_PERIOD.
+ * @return The length of the waveform, or -1 if the index is invalid.
+ */
+int pwm_output_waveform_set(unsigned int index, uint32_t r, uint32_t g, uint32_t b)
+{
+    const uint32_t rgb[PWM_LED_CHANNELS] = {r, g, b};
+    if (index > waveform_length || index >= PWM_WAVEFORM_MAX_SAMPLES) {
+        return -1;
+    }
+    pwm_output_waveform_stop();
+
+    // Same conversion as PWMPulseWidthSet() in up/down mode
+    for (unsigned int i = 0; i < PWM_LED_CHANNELS; ++i) {
+        const PwmChannel *channel = &pwm_channels[i];
+        waveform[i][index] = HWREG(pwm_output_gen_register(channel, PWM_O_X_LOAD)) - pwm_output_scale(rgb[i]) / 2;
+    }
+    waveform_length = index + 1;
+    return (int)waveform_length;
+}
+
+/**
+ * @brief Arms the uDMA transfer of the waveform on a free control structure.
+ */
+static void pwm_output_waveform_arm(unsigned int index, uint32_t select)
+{
+    const uint32_t dma_channel = waveform_channels[index].dma_channel;
+    if (uDMAChannelModeGet(dma_channel | select) == UDMA_MODE_STOP) {
+        uDMAChannelTransferSet(dma_channel | select, UDMA_MODE_PINGPONG, waveform[index],
+                               (void *)pwm_output_compare(&pwm_channels[index]), waveform_length);
+    }
+}
+
+/**
+ * @brief Re-arms a waveform channel after a pass, called from its timer ISR.
+ * 
+ * Both control structures play the whole table, so one is re-armed while
+ * the other plays and the waveform loops without a gap.
+ */
+static void pwm_output_waveform_service(unsigned int index)
+{
+    const uint32_t timer_base = waveform_channels[index].timer_base;
+    TimerIntClear(timer_base, TimerIntStatus(timer_base, true));
+    if (waveform_playing) {
+        pwm_output_waveform_arm(index, UDMA_PRI_SELECT);
+        pwm_output_waveform_arm(index, UDMA_ALT_SELECT);
+    }
+}
+
+/**
+ * @brief Timer 0A interrupt handler, raised when a red waveform pass completes.
+ */
+void Timer0AIntHandler(void) // cppcheck-suppress unusedFunction - this is defined in the ISR vector table
+{
+    pwm_output_waveform_service(0);
+}
+
+/**
+ * @brief Timer 1A interrupt handler, raised when a green waveform pass completes.
+ */
+void Timer1AIntHandler(void) // cppcheck-suppress unusedFunction - this is defined in the ISR vector table
+{
+    pwm_output_waveform_service(1);
+}
+
+/**
+ * @brief Timer 2A interrupt handler, raised when a blue waveform pass completes.
+ */
+void Timer2AIntHandler(void) // cppcheck-suppress unusedFunction - this is defined in the ISR vector table
+{
+    pwm_output_waveform_service(2);
+}
+
+/**
+ * @brief Plays the stored waveform in a loop by uDMA.
+ * 
+ * Each sample is held for hold_periods PWM periods. The samples are written
+ * at the middle of a period and take effect at the start of the next one,
+ * with no CPU involvement other than re-arming the uDMA once per pass. A
+ * fade in progress is stopped. uDMA must be enabled.
+ * 
+ * @param hold_periods The number of PWM periods each sample is held.
+ * @return 0 on success, -1 if there is no waveform or hold_periods is 0 or
+ *         too long for the timers.
+ */
+int pwm_output_waveform_play(uint32_t hold_periods)
+{
+    const uint64_t timer_period = (uint64_t)hold_periods * period * (SysCtlClockGet() / pwm_output_clock());
+    if (waveform_length == 0 || hold_periods == 0 || timer_period > UINT32_MAX) {
+        return -1;
+    }
+    pwm_output_take();
+
+    for (unsigned int i = 0; i < PWM_LED_CHANNELS; ++i) {
+        const WaveformChannel *waveform_channel = &waveform_channels[i];
+        const PwmChannel *channel = &pwm_channels[i];
+        TimerConfigure(waveform_channel->timer_base, TIMER_CFG_PERIODIC);
+        TimerLoadSet(waveform_channel->timer_base, TIMER_A, (uint32_t)timer_period - 1);
+
+        uDMAChannelAssign(waveform_channel->dma_assignment);
+        uDMAChannelAttributeDisable(waveform_channel->dma_channel, UDMA_ATTR_ALL);
+        uDMAChannelControlSet(waveform_channel->dma_channel | UDMA_PRI_SELECT, UDMA_SIZE_32 | UDMA_SRC_INC_32 | UDMA_DST_INC_NONE | UDMA_ARB_1);
+        uDMAChannelControlSet(waveform_channel->dma_channel | UDMA_ALT_SELECT, UDMA_SIZE_32 | UDMA_SRC_INC_32 | UDMA_DST_INC_NONE | UDMA_ARB_1);
+        pwm_output_waveform_arm(i, UDMA_PRI_SELECT);
+        pwm_output_waveform_arm(i, UDMA_ALT_SELECT);
+        uDMAChannelEnable(waveform_channel->dma_channel);
+
+        // The uDMA cannot request a global synchronization, so the compare
+        // registers update at the next zero. All three are written at the same
+        // time in the middle of a period, so a period still never mixes colors.
+        HWREG(pwm_output_gen_register(channel, PWM_O_X_CTL)) &= ~pwm_output_compare_update_bit(channel);
+    }
+
+    // The timers are started from the next counter load interrupt
+    waveform_playing = true;
+    waveform_start_pending = true;
+    PWMGenIntClear(PWM1_BASE, PWM_GEN_3, PWM_INT_CNT_LOAD);
+    PWMGenIntTrigEnable(PWM1_BASE, PWM_GEN_3, PWM_INT_CNT_LOAD);
+    return 0;
+}
+
+/**
+ * @brief Returns the index of the generator of a channel in a list, or
+ * count if it is not listed.
+ */
+static unsigned int pwm_output_find_gen(const uint32_t *gen_bases, const uint32_t *gens, unsigned int count,
+                                        const PwmChannel *channel)
+{
+    unsigned int k = 0;
+    while (k < count && (gen_bases[k] != channel->pwm_base || gens[k] != channel->gen)) {
+        ++k;
+    }
+    return k;
+}
+
+/**
+ * @brief Returns the generators of the first channels as a bit mask, four
+ * bits per module.
+ */
+static uint32_t pwm_output_gen_mask(unsigned int count)
+{
+    uint32_t mask = 0;
+    for (unsigned int i = 0; i < count; ++i) {
+        const uint32_t module = pwm_channels[i].pwm_base == PWM1_BASE ? 4 : 0;
+        mask |= 1u << (module + (pwm_channels[i].gen / PWM_GEN_0) - 1);
+    }
+    return mask;
+}
+
+/**
+ * @brief Restarts the generators in use with their phase offsets.
+ * 
+ * The generators of the enabled channels, in channel order, are started at
+ * offsets of period / N from each other, or all together when not
+ * staggered. PWM has no phase register, so each generator is enabled after
+ * a delay from the common time base; the offsets are approximate if an
+ * interrupt runs in between. The outputs are low for up to one period.
+ * 
+ * This waits for the pending synchronization and between the generators,
+ * so it is run from a task rather than a command, once
+ * pwm_output_phases_pending() reports that a change needs it.
+ */
+void pwm_output_apply_phases(void)
+{
+    uint32_t gen_bases[PWM_MODULES * 4];
+    uint32_t gens[PWM_MODULES * 4];
+    unsigned int count = 0;
+
+    // A change made from here on asks for another pass
+    phases_pending = false;
+
+    // Generators of the enabled channels, each once
+    for (unsigned int i = 0; i < channel_count; ++i) {
+        if (pwm_output_find_gen(gen_bases, gens, count, &pwm_channels[i]) == count) {
+            gen_bases[count] = pwm_channels[i].pwm_base;
+            gens[count] = pwm_channels[i].gen;
+            ++count;
+        }
+    }
+
+    // Pending updates are committed at the counter zero, let them complete
+    while ((HWREG(PWM0_BASE + PWM_O_CTL) | HWREG(PWM1_BASE + PWM_O_CTL)) & PWM_GEN_SYNC_PENDING);
+
+    for (unsigned int i = 0; i < PWM_CHANNEL_COUNT; ++i) {
+        PWMGenDisable(pwm_channels[i].pwm_base, pwm_channels[i].gen);
+    }
+    for (unsigned int m = 0; m < PWM_MODULES; ++m) {
+        if (pwm_gen_bits[m] != 0) {
+            PWMSyncTimeBase(pwm_bases[m], pwm_gen_bits[m]);
+        }
+    }
+
+    // SysCtlDelay() takes 3 CPU cycles per loop
+    const uint32_t cycles = stagger ? period * (SysCtlClockGet() / pwm_output_clock()) / count : 0;
+    // Generators of disabled channels only start with the first one
+    for (unsigned int i = channel_count; i < PWM_CHANNEL_COUNT; ++i) {
+        if (pwm_output_find_gen(gen_bases, gens, count, &pwm_channels[i]) == count) {
+            PWMGenEnable(pwm_channels[i].pwm_base, pwm_channels[i].gen);
+        }
+    }
+    for (unsigned int k = 0; k < count; ++k) {
+        if (k != 0 && cycles >= 3) {
+            SysCtlDelay(cycles / 3);
+        }
+        PWMGenEnable(gen_bases[k], gens[k]);
+    }
+
+    // The LED generator has restarted, count its periods from its next zero
+    const uint32_t basepri = CPUbasepriGet();
+    CPUbasepriSet(PWM_OUTPUT_INT_PRIORITY);
+    pwm_output_watch_zero();
+    if (!rebase_pending) {
+        next_period_cycles = period_cycles;
+    }
+    rebase_pending = true;
+    CPUbasepriSet(basepri);
+}
+
+/**
+ * @brief Finds the smallest PWM clock divider for a frequency.
+ * 
+ * @param sysclk The system clock frequency in Hz.
+ * @param hz The PWM frequency in Hz.
+ * @param period Set to the period in PWM clock cycles.
+ * @return The index of the divider in pwm_dividers, or -1 if the period
+ * would be out of range with every divider.
+ */
+static int pwm_output_divider(uint32_t sysclk, uint32_t hz, uint32_t *period)
+{
+    if (hz == 0) {
+        return -1;
+    }
+    for (unsigned int d = 0; d < sizeof(pwm_dividers) / sizeof(pwm_dividers[0]); ++d) {
+        *period = (sysclk >> d) / hz;
+        if (*period <= PWM_MAX_PERIOD) {
+            return *period >= PWM_MIN_PERIOD ? (int)d : -1;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Checks that a PWM frequency can be set with a system clock.
+ * 
+ * @param hz The PWM frequency in Hz.
+ * @param sysclk The system clock frequency in Hz.
+ * @return true if the frequency is in range.
+ */
+bool pwm_output_frequency_valid(uint32_t hz, uint32_t sysclk)
+{
+    uint32_t new_period;
+    return pwm_output_divider(sysclk, hz, &new_period) >= 0;
+}
+
+/**
+ * @brief Changes the PWM frequency of all channels.
+ * 
+ * Chooses the smallest PWM clock divider for which the period fits in
+ * PWM_MAX_PERIOD, for the best resolution. The current widths are rescaled
+ * to the new period and committed together with it, so the duty cycles
+ * stay the same. A new divider takes effect at once while the period waits
+ * for the synchronization, so when the divider changes the outputs are
+ * held low until the new period is in use, the rest of the current period
+ * and up to one new period, rather than run one period at the wrong
+ * length. A fade or dithering continues at the new rate; a waveform is
+ * stopped, with its table rescaled. Staggered phase offsets are marked for
+ * recomputation.
+ * 
+ * @param hz The PWM frequency in Hz.
+ * @return 0 on success, -1 if the frequency is out of range.
+ */
+int pwm_output_set_frequency(uint32_t hz)
+{
+    uint32_t new_period;
+    const int d = pwm_output_divider(SysCtlClockGet(), hz, &new_period);
+    if (d < 0) {
+        return -1;
+    }
+
+    // Keep the LED interrupt from writing widths with a half-changed scale
+    IntDisable(INT_PWM1_3);
+    pwm_output_waveform_stop();
+    const uint32_t old_period = period;
+    period = new_period;
+    width_scale = (uint32_t)(((uint64_t)new_period << 16) / PWM_PERIOD);
+    output_scale = (uint32_t)(((uint64_t)width_scale * stage_scale) >> 16);
+
+    // The load and compare registers take the new values at the global sync
+    for (unsigned int m = 0; m < PWM_MODULES; ++m) {
+        for (unsigned int g = 0; g < 4; ++g) {
+            if (pwm_gen_bits[m] & (1u << g)) {
+                PWMGenPeriodSet(pwm_bases[m], PWM_GEN_0 * (g + 1), period);
+            }
+        }
+    }
+    // Same conversion as PWMPulseWidthSet() in up/down mode, against the new load value
+    for (unsigned int i = 0; i < PWM_CHANNEL_COUNT; ++i) {
+        HWREG(pwm_output_compare(&pwm_channels[i])) = period / 2 - pwm_output_scale(widths[i]) / 2;
+    }
+    for (unsigned int i = 0; i < PWM_LED_CHANNELS; ++i) {
+        for (unsigned int n = 0; n < waveform_length; ++n) {
+            const uint32_t half_width = old_period / 2 - waveform[i][n];
+            waveform[i][n] = period / 2 - (uint32_t)(((uint64_t)half_width * period) / old_period);
+        }
+    }
+
+    if (SysCtlPWMClockGet() != pwm_dividers[d]) {
+        pwm_output_hold(true);
+        SysCtlPWMClockSet(pwm_dividers[d]);
+    }
+    pwm_output_watch_zero();
+    next_period_cycles = new_period << d;
+    rebase_pending = true;
+    update_pending = true;
+    for (unsigned int m = 0; m < PWM_MODULES; ++m) {
+        if (pwm_gen_bits[m] != 0) {
+            PWMSyncUpdate(pwm_bases[m], pwm_gen_bits[m]);
+        }
+    }
+    IntEnable(INT_PWM1_3);
+
+    // The offsets are fractions of the period
+    if (stagger) {
+        phases_pending = true;
+    }
+    return 0;
+}
+
+/**
+ * @brief Sets the number of channels with their outputs enabled.
+ * 
+ * Channels from count on are held low. If staggered and the generators in
+ * use change, the phase offsets are marked for recomputation.
+ * 
+ * @param count The number of channels, PWM_LED_CHANNELS..PWM_CHANNEL_COUNT.
+ * @return 0 on success, -1 if the count is out of range.
+ */
+int pwm_output_set_channel_count(unsigned int count)
+{
+    if (count < PWM_LED_CHANNELS || count > PWM_CHANNEL_COUNT) {
+        return -1;
+    }
+    const bool rephase = stagger && pwm_output_gen_mask(count) != pwm_output_gen_mask(channel_count);
+    const uint32_t basepri = CPUbasepriGet();
+    CPUbasepriSet(PWM_OUTPUT_INT_PRIORITY);
+    channel_count = count;
+    total = 0;
+    for (unsigned int i = 0; i < count; ++i) {
+        total += widths[i];
+    }
+    // Held outputs are enabled when released
+    for (unsigned int i = 0; i < PWM_CHANNEL_COUNT; ++i) {
+        PWMOutputState(pwm_channels[i].pwm_base, pwm_channels[i].out_bit, i < count && !outputs_held);
+    }
+    CPUbasepriSet(basepri);
+    // The held channels no longer count against the budget
+    pwm_output_write(0, widths, 0);
+    if (rephase) {
+        phases_pending = true;
+    }
+    return 0;
+}
+
+/**
+ * @brief Enables or disables the phase staggering of the generators.
+ * 
+ * The generators are restarted by the next pwm_output_apply_phases().
+ * 
+ * @param enable If true, the generators in use are spread over the period.
+ */
+void pwm_output_set_stagger(bool enable)
+{
+    stagger = enable;
+    phases_pending = true;
+}
+
+/**
+ * @brief Returns true if the generators wait for pwm_output_apply_phases().
+ */
+bool pwm_output_phases_pending(void)
+{
+    return phases_pending;
+}
+
+/**
+ * @brief Sets the master brightness applied to all channels.
+ * 
+ * Takes effect on all channels at the start of the next period. A waveform
+ * takes the brightness when its samples are set.
+ * 
+ * @param brightness The brightness in 16.16 fixed point, 0..1.0.
+ */
+void pwm_output_set_brightness(uint32_t brightness)
+{
+    output_stage_set_brightness(&stage, brightness);
+    pwm_output_write(0, widths, 0);
+}
+
+/**
+ * @brief Sets the power budget, the largest total of the enabled channels'
+ * widths after the brightness.
+ * 
+ * Above the budget, all channels are scaled down proportionally.
+ * 
+ * @param percent The budget in percent of one channel fully on, 0 for no limit.
+ */
+void pwm_output_set_power_budget(uint32_t percent)
+{
+    output_stage_set_budget(&stage, percent == 0 ? OUTPUT_STAGE_NO_BUDGET : percent * PWM_PERIOD / 100);
+    pwm_output_write(0, widths, 0);
+}
+
+/**
+ * @brief Returns the PWM frequency in Hz.
+ */
+uint32_t pwm_output_frequency(void)
+{
+    return pwm_output_clock() / period;
+}
+
+/**
+ * @brief Returns the number of PWM periods started since initialization.
+ */
+uint32_t pwm_output_period_count(void)
+{
+    const uint32_t basepri = CPUbasepriGet();
+    CPUbasepriSet(PWM_OUTPUT_INT_PRIORITY);
+    const uint32_t count = period_base + (uint32_t)((pwm_output_time() - period_base_time) / period_cycles);
+    CPUbasepriSet(basepri);
+    return count;
+}
+
+/**
+ * @brief Returns the period number in which the last update took effect.
+ */
+uint32_t pwm_output_update_period(void)
+{
+    return update_period;
+}
+
+/**
+ * @brief Configures the PWM modules and pins of the channel map, all
+ * channels off.
+ */
+void pwm_output_init(void)
+{
+    output_stage_init(&stage);
+
+    // Pins of the channels, and the generators and outputs they use
+    for (unsigned int i = 0; i < PWM_CHANNEL_COUNT; ++i) {
+        const PwmChannel *channel = &pwm_channels[i];
+        const unsigned int m = (channel->pwm_base == PWM0_BASE) ? 0 : 1;
+
+        SysCtlPeripheralEnable(channel->gpio_periph);
+        SysCtlPeripheralSleepEnable(channel->gpio_periph);
+        while (!SysCtlPeripheralReady(channel->gpio_periph));
+
+        // PF0 is locked to its NMI function until committed
+        if (channel->gpio_base == GPIO_PORTF_BASE && channel->gpio_pin == GPIO_PIN_0) {
+            HWREG(GPIO_PORTF_BASE + GPIO_O_LOCK) = GPIO_LOCK_KEY;
+            HWREG(GPIO_PORTF_BASE + GPIO_O_CR) |= GPIO_PIN_0;
+            HWREG(GPIO_PORTF_BASE + GPIO_O_LOCK) = 0;
+        }
+        GPIOPinConfigure(channel->pin_config);
+        GPIOPinTypePWM(channel->gpio_base, channel->gpio_pin);
+
+        pwm_gen_bits[m] |= 1u << ((channel->gen / PWM_GEN_0) - 1);
+        pwm_out_bits[m] |= channel->out_bit;
+    }
+
+    // Load, compare and generator updates wait for a global synchronization.
+    for (unsigned int m = 0; m < PWM_MODULES; ++m) {
+        if (pwm_gen_bits[m] == 0) {
+            continue;
+        }
+        SysCtlPeripheralEnable(pwm_periphs[m]);
+        SysCtlPeripheralSleepEnable(pwm_periphs[m]);
+        while (!SysCtlPeripheralReady(pwm_periphs[m]));
+        for (unsigned int g = 0; g < 4; ++g) {
+            if (pwm_gen_bits[m] & (1u << g)) {
+                PWMGenConfigure(pwm_bases[m], PWM_GEN_0 * (g + 1), PWM_GEN_MODE_UP_DOWN | PWM_GEN_MODE_SYNC | PWM_GEN_MODE_GEN_SYNC_GLOBAL);
+                PWMGenPeriodSet(pwm_bases[m], PWM_GEN_0 * (g + 1), PWM_PERIOD);
+            }
+        }
+    }
+    for (unsigned int i = 0; i < PWM_CHANNEL_COUNT; ++i) {
+        PWMPulseWidthSet(pwm_channels[i].pwm_base, pwm_channels[i].out, 0); // 0% duty cycle
+    }
+    for (unsigned int m = 0; m < PWM_MODULES; ++m) {
+        if (pwm_gen_bits[m] != 0) {
+            PWMOutputUpdateMode(pwm_bases[m], pwm_out_bits[m], PWM_OUTPUT_MODE_SYNC_GLOBAL);
+            PWMOutputState(pwm_bases[m], pwm_out_bits[m], true);
+            PWMSyncUpdate(pwm_bases[m], pwm_gen_bits[m]);
+        }
+    }
+
+    // The period count runs on a free-running timer, anchored at the first
+    // counter zero of the LED generator
+    SysCtlPeripheralEnable(PERIOD_TIMER_PERIPH);
+    SysCtlPeripheralSleepEnable(PERIOD_TIMER_PERIPH);
+    while (!SysCtlPeripheralReady(PERIOD_TIMER_PERIPH));
+    TimerConfigure(PERIOD_TIMER_BASE, TIMER_CFG_PERIODIC);
+    TimerLoadSet64(PERIOD_TIMER_BASE, UINT64_MAX);
+    TimerEnable(PERIOD_TIMER_BASE, TIMER_A);
+    period_cycles = PWM_PERIOD * (SysCtlClockGet() / pwm_output_clock());
+    period_base_time = pwm_output_time();
+    pwm_output_watch_zero();
+    next_period_cycles = period_cycles;
+    rebase_pending = true;
+    PWMIntEnable(PWM1_BASE, PWM_INT_GEN_3);
+    IntPrioritySet(INT_PWM1_3, PWM_OUTPUT_INT_PRIORITY);
+    IntEnable(INT_PWM1_3);
+
+    // Timers pacing the waveform uDMA, their interrupts signal a completed pass
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER0);
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER1);
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER2);
+    SysCtlPeripheralSleepEnable(SYSCTL_PERIPH_TIMER0);
+    SysCtlPeripheralSleepEnable(SYSCTL_PERIPH_TIMER1);
+    SysCtlPeripheralSleepEnable(SYSCTL_PERIPH_TIMER2);
+    while (!SysCtlPeripheralReady(SYSCTL_PERIPH_TIMER0) || !SysCtlPeripheralReady(SYSCTL_PERIPH_TIMER1) ||
+           !SysCtlPeripheralReady(SYSCTL_PERIPH_TIMER2));
+    IntPrioritySet(INT_TIMER0A, PWM_OUTPUT_INT_PRIORITY);
+    IntPrioritySet(INT_TIMER1A, PWM_OUTPUT_INT_PRIORITY);
+    IntPrioritySet(INT_TIMER2A, PWM_OUTPUT_INT_PRIORITY);
+    IntEnable(INT_TIMER0A);
+    IntEnable(INT_TIMER1A);
+    IntEnable(INT_TIMER2A);
+
+    for (unsigned int i = 0; i < PWM_CHANNEL_COUNT; ++i) {
+        PWMGenEnable(pwm_channels[i].pwm_base, pwm_channels[i].gen);
+    }
+
+    // Start the generators from zero so their periods line up
+    for (unsigned int m = 0; m < PWM_MODULES; ++m) {
+        if (pwm_gen_bits[m] != 0) {
+            PWMSyncTimeBase(pwm_bases[m], pwm_gen_bits[m]);
+        }
+    }
+}
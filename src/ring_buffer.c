@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * Lock-free single-producer/single-consumer byte ring buffer.
+ */
+
+#include <string.h>
+#include "ring_buffer.h"
+
+// Orders the data accesses against the index updates. On Cortex-M4 this is a DMB.
+#define RING_BUFFER_RELEASE() __atomic_thread_fence(__ATOMIC_RELEASE)
+#define RING_BUFFER_ACQUIRE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+
+/**
+ * @brief Initializes the ring buffer to empty.
+ * 
+ * @param ring Pointer to the RingBuffer structure to initialize.
+ */
+void ring_buffer_init(RingBuffer *ring) {
+    ring->head = 0;
+    ring->tail = 0;
+}
+
+/**
+ * @brief Appends a byte to the ring.
+ * 
+ * Must only be called from the producer side.
+ * 
+ * @param ring Pointer to the RingBuffer structure.
+ * @param c The byte to append.
+ * @return 0 on success, -1 if the ring is full.
+ */
+int ring_buffer_put(RingBuffer *ring, unsigned char c) {
+    const unsigned int head = ring->head;
+    if (head - ring->tail >= RING_BUFFER_SIZE) {
+        return -1;
+    }
+    RING_BUFFER_ACQUIRE();
+    ring->data[head & (RING_BUFFER_SIZE - 1)] = c;
+    RING_BUFFER_RELEASE();
+    ring->head = head + 1;
+    return 0;
+}
+
+/**
+ * @brief Removes the oldest byte from the ring.
+ * 
+ * Must only be called from the consumer side.
+ * 
+ * @param ring Pointer to the RingBuffer structure.
+ * @param c Pointer where the byte is stored.
+ * @return 0 on success, -1 if the ring is empty.
+ */
+int ring_buffer_get(RingBuffer *ring, unsigned char *c) {
+    const unsigned int tail = ring->tail;
+    if (ring->head == tail) {
+        return -1;
+    }
+    RING_BUFFER_ACQUIRE();
+    *c = ring->data[tail & (RING_BUFFER_SIZE - 1)];
+    RING_BUFFER_RELEASE();
+    ring->tail = tail + 1;
+    return 0;
+}
+
+/**
+ * @brief Returns the number of bytes in the ring.
+ * 
+ * @param ring Pointer to the RingBuffer structure.
+ */
+unsigned int ring_buffer_count(const RingBuffer *ring) {
+    return ring->head - ring->tail;
+}
+
+/**
+ * @brief Appends as many bytes as fit to the ring.
+ * 
+ * Must only be called from the producer side.
+ * 
+ * @param ring Pointer to the RingBuffer structure.
+ * @param data Pointer to the bytes to append.
+ * @param length Number of bytes to append.
+ * @return Number of bytes appended.
+ */
+size_t ring_buffer_write(RingBuffer *ring, const unsigned char *data, size_t length) {
+    const unsigned int head = ring->head;
+    const size_t space = RING_BUFFER_SIZE - (head - ring->tail);
+    if (length > space) {
+        length = space;
+    }
+    RING_BUFFER_ACQUIRE();
+
+    const size_t offset = head & (RING_BUFFER_SIZE - 1);
+    const size_t first = (length < RING_BUFFER_SIZE - offset) ? length : RING_BUFFER_SIZE - offset;
+    memcpy(&ring->data[offset], data, first);
+    memcpy(ring->data, &data[first], length - first);
+
+    RING_BUFFER_RELEASE();
+    ring->head = head + (unsigned int)length;
+    return length;
+}
+
+/**
+ * @brief Returns the oldest contiguous run of bytes in the ring.
+ * 
+ * Must only be called from the consumer side. The bytes stay in the ring
+ * until ring_buffer_consume() is called, which makes it possible to hand
+ * them to DMA directly.
+ * 
+ * @param ring Pointer to the RingBuffer structure.
+ * @param data Pointer where the start of the run is stored.
+ * @return Number of bytes in the run, 0 if the ring is empty.
+ */
+size_t ring_buffer_peek(const RingBuffer *ring, const unsigned char **data) {
+    const unsigned int tail = ring->tail;
+    const size_t count = ring->head - tail;
+    const size_t offset = tail & (RING_BUFFER_SIZE - 1);
+    RING_BUFFER_ACQUIRE();
+    *data = &ring->data[offset];
+    return (count < RING_BUFFER_SIZE - offset) ? count : RING_BUFFER_SIZE - offset;
+}
+
+/**
+ * @brief Removes bytes returned by ring_buffer_peek() from the ring.
+ * 
+ * @param ring Pointer to the RingBuffer structure.
+ * @param length Number of bytes to remove.
+ */
+void ring_buffer_consume(RingBuffer *ring, size_t length) {
+    RING_BUFFER_RELEASE();
+    ring->tail = ring->tail + (unsigned int)length;
+}
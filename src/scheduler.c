@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * Cooperative scheduler. Tasks are registered in a static table and run to
+ * completion from the main loop when their release tick has come, in table
+ * order. A periodic task that falls behind skips the releases it missed
+ * instead of running back to back.
+ */
+
+#include <stddef.h>
+
+#include "scheduler.h"
+
+/**
+ * @brief Returns true if tick a is at or after tick b, across wrap-around.
+ */
+static bool scheduler_reached(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) >= 0;
+}
+
+/**
+ * @brief Initializes the scheduler with an empty task table.
+ * 
+ * @param scheduler Pointer to the Scheduler structure to initialize.
+ * @param ticks Returns the current tick, for the releases and deadlines.
+ * @param cycles Returns a free-running cycle count, for the run times.
+ */
+void scheduler_init(Scheduler *scheduler, SchedulerClock ticks, SchedulerClock cycles) {
+    scheduler->count = 0;
+    scheduler->ticks = ticks;
+    scheduler->cycles = cycles;
+}
+
+/**
+ * @brief Adds a task to the table, stopped.
+ * 
+ * @param scheduler Pointer to the Scheduler structure.
+ * @param function The task function, run to completion.
+ * @param period Ticks between releases, or SCHEDULER_ONE_SHOT.
+ * @param deadline Ticks from a release to the completion of the run.
+ * @return The task number, or -1 if the table is full.
+ */
+int scheduler_add(Scheduler *scheduler, SchedulerTask function, uint32_t period, uint32_t deadline) {
+    if (scheduler->count >= SCHEDULER_MAX_TASKS) {
+        return -1;
+    }
+    Task *task = &scheduler->tasks[scheduler->count];
+    task->function = function;
+    task->period = period;
+    task->deadline = deadline;
+    task->release = 0;
+    task->armed = false;
+    task->runs = 0;
+    task->misses = 0;
+    task->max_cycles = 0;
+    task->total_cycles = 0;
+    return (int)scheduler->count++;
+}
+
+/**
+ * @brief Releases a task after a delay, and then every period.
+ * 
+ * Restarting a started task moves its next release.
+ * 
+ * @param scheduler Pointer to the Scheduler structure.
+ * @param task The task number.
+ * @param delay Ticks from now to the first release.
+ * @return 0 on success, -1 if there is no such task.
+ */
+int scheduler_start(Scheduler *scheduler, int task, uint32_t delay) {
+    if (task < 0 || (unsigned int)task >= scheduler->count) {
+        return -1;
+    }
+    scheduler->tasks[task].release = scheduler->ticks() + delay;
+    scheduler->tasks[task].armed = true;
+    return 0;
+}
+
+/**
+ * @brief Cancels the pending release of a task.
+ * 
+ * @param scheduler Pointer to the Scheduler structure.
+ * @param task The task number.
+ */
+void scheduler_stop(Scheduler *scheduler, int task) {
+    if (task >= 0 && (unsigned int)task < scheduler->count) {
+        scheduler->tasks[task].armed = false;
+    }
+}
+
+/**
+ * @brief Runs every task whose release has come, once.
+ * 
+ * The next release is set before a task runs, so the task may restart or
+ * stop itself. Called from the main loop.
+ * 
+ * @param scheduler Pointer to the Scheduler structure.
+ * @return The number of tasks run.
+ */
+unsigned int scheduler_run(Scheduler *scheduler) {
+    unsigned int ran = 0;
+    for (unsigned int i = 0; i < scheduler->count; ++i) {
+        Task *task = &scheduler->tasks[i];
+        const uint32_t now = scheduler->ticks();
+        if (!task->armed || !scheduler_reached(now, task->release)) {
+            continue;
+        }
+
+        const uint32_t release = task->release;
+        if (task->period == SCHEDULER_ONE_SHOT) {
+            task->armed = false;
+        } else {
+            do {
+                task->release += task->period;
+            } while (scheduler_reached(now, task->release));
+        }
+        const uint32_t next = task->release;
+
+        const uint32_t start = scheduler->cycles();
+        task->function();
+        const uint32_t cycles = scheduler->cycles() - start;
+        const uint32_t end = scheduler->ticks();
+
+        task->runs++;
+        task->total_cycles += cycles;
+        if (cycles > task->max_cycles) {
+            task->max_cycles = cycles;
+        }
+        if (end - release > task->deadline) {
+            task->misses++;
+        }
+        // Skip the releases passed during an overrun, unless the task restarted itself
+        if (task->armed && task->period != SCHEDULER_ONE_SHOT && task->release == next) {
+            while ((int32_t)(end - task->release) > 0) {
+                task->release += task->period;
+            }
+        }
+        ran++;
+    }
+    return ran;
+}
+
+/**
+ * @brief Returns true if the release of any task has come.
+ * 
+ * @param scheduler Pointer to the Scheduler structure.
+ */
+bool scheduler_due(const Scheduler *scheduler) {
+    const uint32_t now = scheduler->ticks();
+    for (unsigned int i = 0; i < scheduler->count; ++i) {
+        if (scheduler->tasks[i].armed && scheduler_reached(now, scheduler->tasks[i].release)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Returns a task with its statistics.
+ * 
+ * @param scheduler Pointer to the Scheduler structure.
+ * @param task The task number.
+ * @return Pointer to the task, or NULL if there is no such task.
+ */
+const Task *scheduler_task(const Scheduler *scheduler, int task) {
+    if (task < 0 || (unsigned int)task >= scheduler->count) {
+        return NULL;
+    }
+    return &scheduler->tasks[task];
+}
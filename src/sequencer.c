@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * Keyframe sequencer. Each keyframe is reached from the previous one over its
+ * duration along its easing curve. The position within a transition is kept
+ * in 1/256 steps, so the interpolation needs one division per tick.
+ */
+
+#include "sequencer.h"
+
+#define SEQUENCER_ONE 256
+
+/**
+ * @brief Applies an easing curve to a position in 0..SEQUENCER_ONE.
+ */
+static uint32_t sequencer_ease(uint8_t easing, uint32_t t) {
+    switch (easing) {
+    case EASING_IN:
+        return (t * t) >> 8;
+    case EASING_OUT:
+        return SEQUENCER_ONE - (((SEQUENCER_ONE - t) * (SEQUENCER_ONE - t)) >> 8);
+    case EASING_IN_OUT:
+        if (t < SEQUENCER_ONE / 2) {
+            return (t * t) >> 7;
+        }
+        return SEQUENCER_ONE - (((SEQUENCER_ONE - t) * (SEQUENCER_ONE - t)) >> 7);
+    case EASING_STEP:
+        return t < SEQUENCER_ONE ? 0 : SEQUENCER_ONE;
+    default:
+        return t;
+    }
+}
+
+/**
+ * @brief Initializes the sequencer with no keyframes.
+ * 
+ * @param seq Pointer to the Sequencer structure to initialize.
+ * @param output Callback receiving every new color while playing.
+ */
+void sequencer_init(Sequencer *seq, SequencerOutput output) {
+    seq->count = 0;
+    seq->index = 0;
+    seq->elapsed_ms = 0;
+    seq->playing = false;
+    seq->loop = false;
+    seq->output = output;
+    for (int i = 0; i < 3; ++i) {
+        seq->from[i] = 0;
+        seq->color[i] = 0;
+    }
+}
+
+/**
+ * @brief Stores uploaded keyframes, stopping playback.
+ * 
+ * The keyframes are SEQUENCER_KEYFRAME_LENGTH bytes each and are stored
+ * starting at index first, which must not be past the stored keyframes. The
+ * sequence ends after the last keyframe stored, so first 0 starts a new
+ * sequence and first equal to the count appends to it.
+ * 
+ * @param seq Pointer to the Sequencer structure.
+ * @param first Index of the first keyframe in data.
+ * @param data The keyframes.
+ * @param length Length of data in bytes.
+ * @return The number of keyframes in the sequence, or -1 if rejected.
+ */
+int sequencer_load(Sequencer *seq, unsigned int first, const uint8_t *data, size_t length) {
+    const size_t count = length / SEQUENCER_KEYFRAME_LENGTH;
+    if (count == 0 || length % SEQUENCER_KEYFRAME_LENGTH != 0 || first > seq->count ||
+        count > SEQUENCER_MAX_KEYFRAMES - first) {
+        return -1;
+    }
+
+    sequencer_stop(seq);
+    for (size_t i = 0; i < count; ++i) {
+        Keyframe *kf = &seq->keyframes[first + i];
+        const uint8_t *src = &data[i * SEQUENCER_KEYFRAME_LENGTH];
+        kf->color[0] = src[0];
+        kf->color[1] = src[1];
+        kf->color[2] = src[2];
+        kf->easing = src[3];
+        kf->duration_ms = (uint16_t)(src[4] | (src[5] << 8));
+    }
+    seq->count = first + (unsigned int)count;
+    return (int)seq->count;
+}
+
+/**
+ * @brief Starts playing the sequence from its first keyframe.
+ * 
+ * @param seq Pointer to the Sequencer structure.
+ * @param loop If true, the sequence restarts after the last keyframe.
+ * @param from The color to transition into the first keyframe from.
+ * @return 0 on success, -1 if there are no keyframes.
+ */
+int sequencer_play(Sequencer *seq, bool loop, const uint8_t *from) {
+    if (seq->count == 0) {
+        return -1;
+    }
+    sequencer_stop(seq);
+    for (int i = 0; i < 3; ++i) {
+        seq->from[i] = from[i];
+        seq->color[i] = from[i];
+    }
+    seq->index = 0;
+    seq->elapsed_ms = 0;
+    seq->loop = loop;
+    seq->playing = true;
+    return 0;
+}
+
+/**
+ * @brief Stops playback, leaving the last color output.
+ */
+void sequencer_stop(Sequencer *seq) {
+    seq->playing = false;
+}
+
+/**
+ * @brief Advances the sequence by one millisecond.
+ * 
+ * Called from the millisecond timer. The output callback is called when the
+ * interpolated color changes.
+ * 
+ * @param seq Pointer to the Sequencer structure.
+ */
+void sequencer_tick(Sequencer *seq) {
+    if (!seq->playing) {
+        return;
+    }
+
+    const Keyframe *kf = &seq->keyframes[seq->index];
+    seq->elapsed_ms++;
+    const bool done = seq->elapsed_ms >= kf->duration_ms;
+    const uint32_t t = done ? SEQUENCER_ONE : (seq->elapsed_ms * SEQUENCER_ONE) / kf->duration_ms;
+    const uint32_t e = sequencer_ease(kf->easing, t);
+
+    bool changed = false;
+    for (int i = 0; i < 3; ++i) {
+        const uint8_t c = (uint8_t)((seq->from[i] * (SEQUENCER_ONE - e) + kf->color[i] * e) >> 8);
+        changed |= (c != seq->color[i]);
+        seq->color[i] = c;
+    }
+    if (changed && seq->output != NULL) {
+        seq->output(seq->color[0], seq->color[1], seq->color[2]);
+    }
+
+    if (done) {
+        for (int i = 0; i < 3; ++i) {
+            seq->from[i] = kf->color[i];
+        }
+        seq->elapsed_ms = 0;
+        if (++seq->index >= seq->count) {
+            seq->index = 0;
+            seq->playing = seq->loop;
+        }
+    }
+}
@@ -5,57 +5,267 @@
  */
 
 #include <stdio.h>
+#include <stdint.h>
 #include <string.h>
 #include "serial_handler.h"
+#include "frame_queue.h"
+#include "profile.h"
+#include "driverlib/sw_crc.h"
+
+/**
+ * @brief Command handler for OPCODE_SET_LED_COLOR.
+ * 
+ * Stores the color, applies it through the PWM callback and acknowledges.
+ */
+static size_t set_led_color_command(SerialPortHandler *handler, const __uint8_t *payload, size_t payload_length, __uint8_t *response) {
+    (void)payload_length;
+    handler->r = payload[0];
+    handler->g = payload[1];
+    handler->b = payload[2];
+    if (handler->pwm_callback != NULL) {
+        handler->pwm_callback(handler->r, handler->g, handler->b);
+    }
+    response[0] = 1;
+    return 1;
+}
+
+/**
+ * @brief Command handler for OPCODE_GET_LED_COLOR.
+ * 
+ * Responds with the last color set.
+ */
+static size_t get_led_color_command(SerialPortHandler *handler, const __uint8_t *payload, size_t payload_length, __uint8_t *response) {
+    (void)payload;
+    (void)payload_length;
+    response[0] = handler->r;
+    response[1] = handler->g;
+    response[2] = handler->b;
+    return 3;
+}
+
+/**
+ * @brief Command handler for OPCODE_BATCH.
+ * 
+ * The payload is a sequence of sub-commands, each an opcode followed by its
+ * payload. Sub-commands are executed in order until the payload ends or a
+ * sub-command is invalid (unknown, variable length, truncated, or its
+ * response would not fit). The response is the number of executed
+ * sub-commands followed by their responses concatenated.
+ */
+static size_t batch_command(SerialPortHandler *handler, const __uint8_t *payload, size_t payload_length, __uint8_t *response) {
+    size_t offset = 0;
+    size_t response_length = 1;
+    __uint8_t executed = 0;
+
+    while (offset < payload_length) {
+        const __uint8_t opcode = payload[offset];
+        if (opcode >= COMMAND_TABLE_SIZE) {
+            break;
+        }
+        const CommandEntry *entry = &handler->commands[opcode];
+        if (entry->handler == NULL || entry->payload_length == PAYLOAD_LENGTH_VARIABLE) {
+            break;
+        }
+        if (offset + 1 + entry->payload_length > payload_length) {
+            break;
+        }
+        if (response_length + entry->response_length > MAX_RESPONSE_LENGTH) {
+            break;
+        }
+        size_t length = entry->handler(handler, &payload[offset + 1], entry->payload_length, &response[response_length]);
+        if (length > entry->response_length) {
+            length = entry->response_length;
+        }
+        response_length += length;
+        offset += 1 + (size_t)entry->payload_length;
+        executed++;
+    }
+
+    response[0] = executed;
+    return response_length;
+}
 
 /**
  * @brief Initializes the serial port handler.
  * 
  * This function sets the initial values for the buffer index, escape flag,
- * and started flag. It also clears the buffer.
+ * and started flag. It also clears the buffer and registers the built-in
+ * commands in the dispatch table.
  * 
  * @param handler Pointer to the SerialPortHandler structure to initialize.
  */
 void init_serial_port_handler(SerialPortHandler *handler, CommandCallback pwm_callback, UARTSendCallback send_callback) {
     handler->pwm_callback = pwm_callback;
     handler->send_callback = send_callback;
+    handler->send_frame_callback = NULL;
+    handler->frame_queue = NULL;
+    handler->crc_enabled = 0;
+    handler->crc = 0;
+    handler->crc_errors = 0;
+    handler->overflow_errors = 0;
+    handler->commands_handled = 0;
+    handler->frames_valid = 0;
+    handler->sequence_valid = 0;
+    handler->sequence = 0;
     handler->buffer_index = 0;
     handler->escape_flag = 0;
     handler->started = 0;
+    handler->overflow = 0;
     memset(handler->buffer, 0, BUFFER_SIZE);
     handler->r = 0;
     handler->g = 0;
     handler->b = 0;
+    memset(handler->commands, 0, sizeof(handler->commands));
+    (void)serial_register_command(handler, OPCODE_SET_LED_COLOR, set_led_color_command, 3, 1);
+    (void)serial_register_command(handler, OPCODE_GET_LED_COLOR, get_led_color_command, 0, 3);
+    (void)serial_register_command(handler, OPCODE_BATCH, batch_command, PAYLOAD_LENGTH_VARIABLE, MAX_RESPONSE_LENGTH);
+}
+
+/**
+ * @brief Registers a command handler for an opcode.
+ * 
+ * Replaces any handler previously registered for the opcode. Registering a
+ * NULL handler removes the opcode from the dispatch table.
+ * 
+ * @param handler Pointer to the SerialPortHandler structure.
+ * @param opcode The opcode, must be below COMMAND_TABLE_SIZE.
+ * @param command_handler The function that executes the command.
+ * @param payload_length Expected payload length or PAYLOAD_LENGTH_VARIABLE.
+ * @param response_length Maximum response length, up to MAX_RESPONSE_LENGTH.
+ * @return 0 on success, -1 if the opcode or response length is out of range.
+ */
+int serial_register_command(SerialPortHandler *handler, __uint8_t opcode, CommandHandler command_handler, __uint8_t payload_length, __uint8_t response_length) {
+    if (opcode >= COMMAND_TABLE_SIZE || response_length > MAX_RESPONSE_LENGTH) {
+        return -1;
+    }
+    handler->commands[opcode].handler = command_handler;
+    handler->commands[opcode].payload_length = payload_length;
+    handler->commands[opcode].response_length = response_length;
+    return 0;
+}
+
+/**
+ * @brief Looks up the registered command of a request.
+ * 
+ * @param handler Pointer to the SerialPortHandler structure.
+ * @param command Pointer to the request, starting with the message type.
+ * @param length Length of the request.
+ * @param header_length Set to the length of the header before the payload.
+ * @return The command entry, or NULL if the message type, the opcode or the
+ * payload length does not match a registered command.
+ */
+static const CommandEntry *find_command(const SerialPortHandler *handler, const unsigned char *command, size_t length, size_t *header_length) {
+    *header_length = 2;
+    if (length < 2) {
+        return NULL;
+    }
+    if (command[0] == MSG_TYPE_REQUEST_SEQ) {
+        // The sequence number sits between the message type and the opcode
+        *header_length = 3;
+        if (length < *header_length) {
+            return NULL;
+        }
+    } else if (command[0] != MSG_TYPE_REQUEST) {
+        return NULL;
+    }
+
+    const __uint8_t opcode = command[*header_length - 1];
+    if (opcode >= COMMAND_TABLE_SIZE) {
+        return NULL;
+    }
+    const CommandEntry *entry = &handler->commands[opcode];
+    if (entry->handler == NULL) {
+        return NULL;
+    }
+    if (entry->payload_length != PAYLOAD_LENGTH_VARIABLE && entry->payload_length != length - *header_length) {
+        return NULL;
+    }
+    return entry;
 }
 
 /**
  * @brief Handles a received command.
  * 
- * Decodes the bits and acts accordingly.
+ * Looks up the opcode in the dispatch table, checks the payload length and
+ * calls the registered command handler. Unknown opcodes and frames with an
+ * unexpected payload length are ignored. For MSG_TYPE_REQUEST_SEQ the
+ * sequence number is echoed in the response.
  * 
- * @todo This function is called from ISR. Ideally the commands should be handled in a separate task.
+ * This is called from the ISR unless a frame queue has been attached with
+ * serial_set_frame_queue(), in which case it is called from serial_process_frames().
  * 
  * @param command Pointer to the command string to handle.
+ * @param length Length of the command string, without the end character.
+ * @param handler Pointer to the SerialPortHandler structure.
  */
-void handle_command(const unsigned char *command, SerialPortHandler *handler) {
-    const __uint8_t msg_type = command[0];
-    __uint8_t response[3];
-    if (msg_type == MSG_TYPE_REQUEST) {
-        const __uint8_t opcode = command[1];
-        if (opcode == OPCODE_SET_LED_COLOR) {
-            handler->r = command[2];
-            handler->g = command[3];
-            handler->b = command[4];
-            handler->pwm_callback(handler->r, handler->g, handler->b);
-            response[0] = 1;
-            send_serial_response(handler, response, 1);
-        }
-        else if (opcode == OPCODE_GET_LED_COLOR) {
-            response[0] = handler->r;
-            response[1] = handler->g;
-            response[2] = handler->b;
-            send_serial_response(handler, response, 3);
+void handle_command(const unsigned char *command, size_t length, SerialPortHandler *handler) {
+    __uint8_t response[MAX_RESPONSE_LENGTH];
+    size_t header_length;
+    const CommandEntry *entry = find_command(handler, command, length, &header_length);
+    if (entry == NULL) {
+        return;
+    }
+    const size_t payload_length = length - header_length;
+
+    handler->commands_handled++;
+    handler->sequence_valid = (command[0] == MSG_TYPE_REQUEST_SEQ);
+    handler->sequence = command[1];
+    size_t response_length = entry->handler(handler, &command[header_length], payload_length, response);
+    if (response_length > entry->response_length) {
+        response_length = entry->response_length;
+    }
+    if (response_length > 0) {
+        send_serial_response(handler, response, response_length);
+    }
+    handler->sequence_valid = 0;
+}
+
+/**
+ * @brief Updates a running CRC-16 with one character.
+ */
+static __uint16_t crc16_update(__uint16_t crc, __uint8_t c) {
+    return Crc16(crc, &c, 1);
+}
+
+/**
+ * @brief Passes a complete frame on for handling.
+ * 
+ * A frame that did not fit the buffer is dropped, as its tail is missing.
+ * If CRC checking is enabled, the frame is dropped unless the running CRC
+ * over the frame and its trailer is zero, and the trailer is stripped.
+ * The frame is then queued if a frame queue is attached, otherwise it is
+ * handled immediately.
+ * 
+ * Frames that passed the CRC, or without CRC name a registered command with
+ * its payload length, are counted as valid. Without CRC, line noise can
+ * still form such a frame, from 2 bytes up.
+ * 
+ * @param handler Pointer to the SerialPortHandler structure.
+ * @param length Length of the frame in the buffer.
+ * @param crc Running CRC-16 over the frame, including the trailer.
+ */
+static void dispatch_frame(SerialPortHandler *handler, size_t length, __uint16_t crc) {
+    if (handler->overflow) {
+        handler->overflow_errors++;
+        return;
+    }
+    if (handler->crc_enabled) {
+        if (length < CRC_LENGTH || crc != 0) {
+            handler->crc_errors++;
+            return;
         }
+        length -= CRC_LENGTH;
+    }
+    size_t header_length;
+    if (handler->crc_enabled || find_command(handler, handler->buffer, length, &header_length) != NULL) {
+        handler->frames_valid++;
+    }
+    if (handler->frame_queue != NULL) {
+        (void)frame_queue_push(handler->frame_queue, handler->buffer, length);
+    } else {
+        PROFILE_BEGIN(start);
+        handle_command(handler->buffer, length, handler);
+        PROFILE_END(PROFILE_HANDLE_COMMAND, start);
     }
 }
 
@@ -73,46 +283,229 @@ void serial_receive_char(SerialPortHandler *handler, __uint8_t c) {
     if (!handler->started) {
         if (c == START_CHAR) {
             handler->started = 1;
+            handler->overflow = 0;
+            handler->crc = 0;
         }
         return;
     }
 
-    if (handler->escape_flag) {
-        handler->escape_flag = 0;
-        if (handler->buffer_index < BUFFER_SIZE - 1) {
-            handler->buffer[handler->buffer_index++] = c;
-        }
-    } else if (c == ESCAPE_CHAR) {
+    if (!handler->escape_flag && c == ESCAPE_CHAR) {
         handler->escape_flag = 1;
-    } else if (c == END_CHAR) {
+        return;
+    }
+    if (!handler->escape_flag && c == END_CHAR) {
         handler->buffer[handler->buffer_index] = c;
-        handle_command(handler->buffer, handler);
+        dispatch_frame(handler, (size_t)handler->buffer_index, handler->crc);
         handler->buffer_index = 0;
         handler->started = 0;
+        return;
+    }
+
+    handler->escape_flag = 0;
+    if (handler->crc_enabled) {
+        handler->crc = crc16_update(handler->crc, c);
+    }
+    if (handler->buffer_index < BUFFER_SIZE - 1) {
+        handler->buffer[handler->buffer_index++] = c;
     } else {
-        if (handler->buffer_index < BUFFER_SIZE - 1) {
-            handler->buffer[handler->buffer_index++] = c;
+        handler->overflow = 1;
+    }
+}
+
+/**
+ * @brief Receives a span of characters from the serial port.
+ * 
+ * Equivalent to calling serial_receive_char() for each byte in the span, but
+ * the framing state is kept in local variables for the duration of the span
+ * and written back to the handler only when a frame completes or the span
+ * ends. This is meant for draining the whole UART FIFO in one call.
+ * 
+ * @param handler Pointer to the SerialPortHandler structure.
+ * @param buf Pointer to the received characters.
+ * @param len Number of characters in the span.
+ */
+void serial_receive_bytes(SerialPortHandler *handler, const __uint8_t *buf, size_t len) {
+    PROFILE_BEGIN(start);
+    unsigned char *const buffer = handler->buffer;
+    const int crc_enabled = handler->crc_enabled;
+    int buffer_index = handler->buffer_index;
+    int escape_flag = handler->escape_flag;
+    int started = handler->started;
+    int overflow = handler->overflow;
+    __uint16_t crc = handler->crc;
+
+    for (size_t i = 0; i < len; ++i) {
+        const __uint8_t c = buf[i];
+        if (!started) {
+            started = (c == START_CHAR);
+            overflow = 0;
+            crc = 0;
+            continue;
+        }
+        if (!escape_flag) {
+            if (c == ESCAPE_CHAR) {
+                escape_flag = 1;
+                continue;
+            }
+            if (c == END_CHAR) {
+                buffer[buffer_index] = c;
+                // Keep the handler consistent while the frame is being dispatched
+                handler->buffer_index = buffer_index;
+                handler->escape_flag = 0;
+                handler->started = 1;
+                handler->overflow = overflow;
+                dispatch_frame(handler, (size_t)buffer_index, crc);
+                buffer_index = 0;
+                started = 0;
+                continue;
+            }
+        }
+        escape_flag = 0;
+        if (crc_enabled) {
+            crc = crc16_update(crc, c);
+        }
+        if (buffer_index < BUFFER_SIZE - 1) {
+            buffer[buffer_index++] = c;
+        } else {
+            overflow = 1;
         }
     }
+
+    handler->buffer_index = buffer_index;
+    handler->escape_flag = escape_flag;
+    handler->started = started;
+    handler->overflow = overflow;
+    handler->crc = crc;
+    PROFILE_END(PROFILE_RECEIVE_BYTES, start);
+}
+
+/**
+ * @brief Enables or disables the CRC-16 frame trailer.
+ * 
+ * When enabled, every request must end with the CRC-16 (as computed by
+ * Crc16() with an initial value of 0) of its unescaped message type, opcode
+ * and payload, least significant byte first. Frames failing the check are
+ * dropped before handle_command() and counted in crc_errors. Responses get
+ * the same trailer.
+ * 
+ * @param handler Pointer to the SerialPortHandler structure.
+ * @param enable Non-zero to enable the CRC trailer.
+ */
+void serial_enable_crc(SerialPortHandler *handler, int enable) {
+    handler->crc_enabled = (enable != 0);
+}
+
+/**
+ * @brief Attaches a frame queue to the serial port handler.
+ * 
+ * Once attached, completed frames are queued by the receive functions and the
+ * commands are executed by serial_process_frames(). Pass NULL to handle the
+ * commands directly in the receive functions again.
+ * 
+ * @param handler Pointer to the SerialPortHandler structure.
+ * @param queue Pointer to an initialized FrameQueue, or NULL.
+ */
+void serial_set_frame_queue(SerialPortHandler *handler, FrameQueue *queue) {
+    handler->frame_queue = queue;
+}
+
+/**
+ * @brief Handles all frames waiting in the frame queue.
+ * 
+ * Meant to be called from the main loop, outside of interrupt context.
+ * 
+ * @param handler Pointer to the SerialPortHandler structure.
+ * @return Number of frames handled.
+ */
+unsigned int serial_process_frames(SerialPortHandler *handler) {
+    unsigned int count = 0;
+    const Frame *frame;
+    if (handler->frame_queue == NULL) {
+        return 0;
+    }
+    while ((frame = frame_queue_peek(handler->frame_queue)) != NULL) {
+        PROFILE_BEGIN(start);
+        handle_command(frame->data, frame->length, handler);
+        PROFILE_END(PROFILE_HANDLE_COMMAND, start);
+        frame_queue_release(handler->frame_queue);
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief Sets a callback that sends a whole encoded frame at once.
+ * 
+ * When set, responses are passed to this callback as one contiguous frame
+ * instead of calling the character send callback for every byte.
+ * 
+ * @param handler Pointer to the SerialPortHandler structure.
+ * @param send_frame_callback The frame send callback, or NULL.
+ */
+void serial_set_frame_sender(SerialPortHandler *handler, UARTSendFrameCallback send_frame_callback) {
+    handler->send_frame_callback = send_frame_callback;
+}
+
+/**
+ * @brief Appends a character to a frame, escaping it if it is a special character.
+ * 
+ * @return The new length of the frame.
+ */
+static size_t put_escaped(__uint8_t *frame, size_t length, __uint8_t c) {
+    if (c == START_CHAR || c == END_CHAR || c == ESCAPE_CHAR) {
+        frame[length++] = ESCAPE_CHAR;
+    }
+    frame[length++] = c;
+    return length;
 }
 
 /**
  * @brief Sends a response over the serial port.
  * 
- * This function sends the response data using the UART send callback.
+ * The response is encoded into the handler's frame buffer and sent with the
+ * frame send callback if one is set, otherwise one character at a time with
+ * the UART send callback.
+ * While a MSG_TYPE_REQUEST_SEQ request is being handled, the response is
+ * sent as MSG_TYPE_RESPONSE_SEQ with the request's sequence number.
+ * Special characters in the data are escaped, and the CRC-16 trailer is
+ * appended if it has been enabled.
  * 
  * @param handler Pointer to the SerialPortHandler structure.
  * @param response Pointer to the response data to send.
- * @param length Length of the response data.
+ * @param length Length of the response data, at most MAX_RESPONSE_LENGTH.
  */
 void send_serial_response(SerialPortHandler *handler, const __uint8_t *response, size_t length) {
-    if (handler->send_callback == NULL) {
+    if (handler->send_callback == NULL && handler->send_frame_callback == NULL) {
         return;
     }
-    handler->send_callback(START_CHAR);
-    handler->send_callback(MSG_TYPE_RESPONSE);
+    if (length > MAX_RESPONSE_LENGTH) {
+        length = MAX_RESPONSE_LENGTH;
+    }
+    const __uint8_t header[2] = {handler->sequence_valid ? MSG_TYPE_RESPONSE_SEQ : MSG_TYPE_RESPONSE, handler->sequence};
+    const size_t header_length = handler->sequence_valid ? 2 : 1;
+    __uint8_t *const frame = handler->tx_frame;
+    size_t frame_length = 0;
+
+    frame[frame_length++] = START_CHAR;
+    for (size_t i = 0; i < header_length; ++i) {
+        frame_length = put_escaped(frame, frame_length, header[i]);
+    }
     for (size_t i = 0; i < length; ++i) {
-        handler->send_callback(response[i]);
+        frame_length = put_escaped(frame, frame_length, response[i]);
+    }
+    if (handler->crc_enabled) {
+        __uint16_t crc = Crc16(0, header, (uint32_t)header_length);
+        crc = Crc16(crc, response, (uint32_t)length);
+        frame_length = put_escaped(frame, frame_length, (__uint8_t)(crc & 0xFF));
+        frame_length = put_escaped(frame, frame_length, (__uint8_t)(crc >> 8));
+    }
+    frame[frame_length++] = END_CHAR;
+
+    if (handler->send_frame_callback != NULL) {
+        handler->send_frame_callback(frame, frame_length);
+    } else {
+        for (size_t i = 0; i < frame_length; ++i) {
+            handler->send_callback(frame[i]);
+        }
     }
-    handler->send_callback(END_CHAR);
 }
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * This file contains unit tests for the temporal dithering.
+ */
+
+#include "unity.h"
+#include "dither.h"
+
+static Dither dither;
+
+void setUp(void) {
+    // This function is run before each test
+    dither_stop(&dither);
+}
+
+void tearDown(void) {
+    // This function is run after each test
+}
+
+void test_dither_should_average_to_fractional_width(void) {
+    // 10.25, 200.5 and 0.75 clock cycles
+    const uint32_t widths[DITHER_CHANNELS] = {(10 << 8) | 64, (200 << 8) | 128, 192};
+    uint32_t out[DITHER_CHANNELS];
+    uint32_t sums[DITHER_CHANNELS] = {0, 0, 0};
+
+    dither_start(&dither, widths);
+    TEST_ASSERT_TRUE(dither_active(&dither));
+    for (int period = 0; period < 256; ++period) {
+        dither_step(&dither, out);
+        TEST_ASSERT_TRUE(out[0] == 10 || out[0] == 11);
+        TEST_ASSERT_TRUE(out[1] == 200 || out[1] == 201);
+        TEST_ASSERT_TRUE(out[2] <= 1);
+        for (int i = 0; i < DITHER_CHANNELS; ++i) {
+            sums[i] += out[i];
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(256 * 10 + 64, sums[0]);
+    TEST_ASSERT_EQUAL_UINT32(256 * 200 + 128, sums[1]);
+    TEST_ASSERT_EQUAL_UINT32(192, sums[2]);
+}
+
+void test_dither_should_spread_ones_evenly(void) {
+    // A half alternates every period
+    const uint32_t widths[DITHER_CHANNELS] = {(5 << 8) | 128, 0, 0};
+    uint32_t out[DITHER_CHANNELS];
+
+    dither_start(&dither, widths);
+    dither_step(&dither, out);
+    const uint32_t first = out[0];
+    for (int period = 0; period < 8; ++period) {
+        dither_step(&dither, out);
+        TEST_ASSERT_EQUAL_UINT32(period % 2 == 0 ? 11 - first : first, out[0]);
+    }
+}
+
+void test_dither_should_be_inactive_without_fractions(void) {
+    const uint32_t widths[DITHER_CHANNELS] = {1 << 8, 2 << 8, 3 << 8};
+    uint32_t out[DITHER_CHANNELS];
+
+    dither_start(&dither, widths);
+    TEST_ASSERT_FALSE(dither_active(&dither));
+    dither_step(&dither, out);
+    TEST_ASSERT_EQUAL_UINT32(1, out[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, out[1]);
+    TEST_ASSERT_EQUAL_UINT32(3, out[2]);
+}
+
+void test_dither_stop_should_end_dithering(void) {
+    const uint32_t widths[DITHER_CHANNELS] = {1, 0, 0};
+    dither_start(&dither, widths);
+    dither_stop(&dither);
+    TEST_ASSERT_FALSE(dither_active(&dither));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_dither_should_average_to_fractional_width);
+    RUN_TEST(test_dither_should_spread_ones_evenly);
+    RUN_TEST(test_dither_should_be_inactive_without_fractions);
+    RUN_TEST(test_dither_stop_should_end_dithering);
+    return UNITY_END();
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * This file contains unit tests for the fixed-point fade.
+ */
+
+#include "unity.h"
+#include "fade.h"
+
+static Fade fade;
+
+void setUp(void) {
+    // This function is run before each test
+    fade_stop(&fade);
+}
+
+void tearDown(void) {
+    // This function is run after each test
+}
+
+void test_fade_should_step_linearly_and_end_at_target(void) {
+    const uint32_t from[FADE_CHANNELS] = {0, 100, 9999};
+    const uint32_t to[FADE_CHANNELS] = {100, 0, 9999};
+    uint32_t widths[FADE_CHANNELS];
+
+    fade_start(&fade, from, to, 4);
+    TEST_ASSERT_TRUE(fade_active(&fade));
+
+    TEST_ASSERT_TRUE(fade_step(&fade, widths));
+    TEST_ASSERT_EQUAL_UINT32(25, widths[0]);
+    TEST_ASSERT_EQUAL_UINT32(75, widths[1]);
+    TEST_ASSERT_EQUAL_UINT32(9999, widths[2]);
+    TEST_ASSERT_TRUE(fade_step(&fade, widths));
+    TEST_ASSERT_EQUAL_UINT32(50, widths[0]);
+    TEST_ASSERT_TRUE(fade_step(&fade, widths));
+    TEST_ASSERT_EQUAL_UINT32(75, widths[0]);
+    TEST_ASSERT_EQUAL_UINT32(25, widths[1]);
+
+    TEST_ASSERT_FALSE(fade_step(&fade, widths));
+    TEST_ASSERT_EQUAL_UINT32(100, widths[0]);
+    TEST_ASSERT_EQUAL_UINT32(0, widths[1]);
+    TEST_ASSERT_EQUAL_UINT32(9999, widths[2]);
+    TEST_ASSERT_FALSE(fade_active(&fade));
+}
+
+void test_fade_should_land_on_target_despite_rounding(void) {
+    const uint32_t from[FADE_CHANNELS] = {0, 65535, 1};
+    const uint32_t to[FADE_CHANNELS] = {65535, 0, 2};
+    uint32_t widths[FADE_CHANNELS];
+    uint32_t steps = 0;
+
+    fade_start(&fade, from, to, 7);
+    while (fade_step(&fade, widths)) {
+        TEST_ASSERT_TRUE(widths[0] <= 65535);
+        TEST_ASSERT_TRUE(widths[1] <= 65535);
+        steps++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(6, steps);
+    TEST_ASSERT_EQUAL_UINT32(65535, widths[0]);
+    TEST_ASSERT_EQUAL_UINT32(0, widths[1]);
+    TEST_ASSERT_EQUAL_UINT32(2, widths[2]);
+}
+
+void test_fade_of_zero_steps_should_jump_to_target(void) {
+    const uint32_t from[FADE_CHANNELS] = {10, 20, 30};
+    const uint32_t to[FADE_CHANNELS] = {40, 50, 60};
+    uint32_t widths[FADE_CHANNELS];
+
+    fade_start(&fade, from, to, 0);
+    TEST_ASSERT_FALSE(fade_step(&fade, widths));
+    TEST_ASSERT_EQUAL_UINT32(40, widths[0]);
+    TEST_ASSERT_EQUAL_UINT32(50, widths[1]);
+    TEST_ASSERT_EQUAL_UINT32(60, widths[2]);
+}
+
+void test_fade_stop_should_end_fade(void) {
+    const uint32_t from[FADE_CHANNELS] = {0, 0, 0};
+    const uint32_t to[FADE_CHANNELS] = {100, 100, 100};
+
+    fade_start(&fade, from, to, 100);
+    fade_stop(&fade);
+    TEST_ASSERT_FALSE(fade_active(&fade));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_fade_should_step_linearly_and_end_at_target);
+    RUN_TEST(test_fade_should_land_on_target_despite_rounding);
+    RUN_TEST(test_fade_of_zero_steps_should_jump_to_target);
+    RUN_TEST(test_fade_stop_should_end_fade);
+    return UNITY_END();
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * This file contains unit tests for the frame queue of the Serial Handler library.
+ */
+
+#include "unity.h"
+#include "serial_handler.h"
+#include "frame_queue.h"
+
+static FrameQueue queue;
+static __uint8_t mock_r, mock_g, mock_b;
+static int mock_calls;
+
+void mock_pwm_callback(__uint8_t r, __uint8_t g, __uint8_t b) {
+    mock_r = r;
+    mock_g = g;
+    mock_b = b;
+    mock_calls++;
+}
+
+void setUp(void) {
+    // This function is run before each test
+    frame_queue_init(&queue);
+    mock_r = 0;
+    mock_g = 0;
+    mock_b = 0;
+    mock_calls = 0;
+}
+
+void tearDown(void) {
+    // This function is run after each test
+}
+
+void test_frame_queue_should_be_empty_after_init(void) {
+    TEST_ASSERT_NULL(frame_queue_peek(&queue));
+    TEST_ASSERT_EQUAL(0, frame_queue_count(&queue));
+}
+
+void test_frame_queue_should_return_frames_in_order(void) {
+    const unsigned char first[] = {1, 2, 3};
+    const unsigned char second[] = {4, 5};
+    TEST_ASSERT_EQUAL(0, frame_queue_push(&queue, first, sizeof(first)));
+    TEST_ASSERT_EQUAL(0, frame_queue_push(&queue, second, sizeof(second)));
+    TEST_ASSERT_EQUAL(2, frame_queue_count(&queue));
+
+    const Frame *frame = frame_queue_peek(&queue);
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL(3, frame->length);
+    TEST_ASSERT_EQUAL(1, frame->data[0]);
+    frame_queue_release(&queue);
+
+    frame = frame_queue_peek(&queue);
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL(2, frame->length);
+    TEST_ASSERT_EQUAL(4, frame->data[0]);
+    frame_queue_release(&queue);
+
+    TEST_ASSERT_NULL(frame_queue_peek(&queue));
+}
+
+void test_frame_queue_should_drop_when_full(void) {
+    const unsigned char data[] = {0xAA};
+    for (int i = 0; i < FRAME_QUEUE_DEPTH; ++i) {
+        TEST_ASSERT_EQUAL(0, frame_queue_push(&queue, data, sizeof(data)));
+    }
+    TEST_ASSERT_EQUAL(-1, frame_queue_push(&queue, data, sizeof(data)));
+    TEST_ASSERT_EQUAL(1, queue.dropped);
+    TEST_ASSERT_EQUAL(FRAME_QUEUE_DEPTH, queue.high_water);
+
+    frame_queue_release(&queue);
+    TEST_ASSERT_EQUAL(0, frame_queue_push(&queue, data, sizeof(data)));
+}
+
+void test_serial_handler_should_defer_commands_to_process_frames(void) {
+    SerialPortHandler handler;
+    init_serial_port_handler(&handler, mock_pwm_callback, NULL);
+    serial_set_frame_queue(&handler, &queue);
+
+    const __uint8_t frame[] = {START_CHAR, MSG_TYPE_REQUEST, OPCODE_SET_LED_COLOR, 10, 20, 30, END_CHAR};
+    serial_receive_bytes(&handler, frame, sizeof(frame));
+    serial_receive_bytes(&handler, frame, sizeof(frame));
+    TEST_ASSERT_EQUAL(0, mock_calls);
+    TEST_ASSERT_EQUAL(2, frame_queue_count(&queue));
+
+    TEST_ASSERT_EQUAL(2, serial_process_frames(&handler));
+    TEST_ASSERT_EQUAL(2, mock_calls);
+    TEST_ASSERT_EQUAL(10, mock_r);
+    TEST_ASSERT_EQUAL(20, mock_g);
+    TEST_ASSERT_EQUAL(30, mock_b);
+    TEST_ASSERT_EQUAL(0, serial_process_frames(&handler));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_frame_queue_should_be_empty_after_init);
+    RUN_TEST(test_frame_queue_should_return_frames_in_order);
+    RUN_TEST(test_frame_queue_should_drop_when_full);
+    RUN_TEST(test_serial_handler_should_defer_commands_to_process_frames);
+    return UNITY_END();
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * This file contains unit tests for the output stage.
+ */
+
+#include "unity.h"
+#include "output_stage.h"
+
+static OutputStage stage;
+
+void setUp(void) {
+    // This function is run before each test
+    output_stage_init(&stage);
+}
+
+void tearDown(void) {
+    // This function is run after each test
+}
+
+void test_output_stage_should_pass_through_by_default(void) {
+    TEST_ASSERT_EQUAL_UINT32(OUTPUT_STAGE_ONE, output_stage_scale(&stage, 0));
+    TEST_ASSERT_EQUAL_UINT32(OUTPUT_STAGE_ONE, output_stage_scale(&stage, 16 * 65535));
+}
+
+void test_output_stage_should_apply_master_brightness(void) {
+    output_stage_set_brightness(&stage, OUTPUT_STAGE_ONE / 4);
+    TEST_ASSERT_EQUAL_UINT32(OUTPUT_STAGE_ONE / 4, output_stage_scale(&stage, 30000));
+
+    output_stage_set_brightness(&stage, 2 * OUTPUT_STAGE_ONE);
+    TEST_ASSERT_EQUAL_UINT32(OUTPUT_STAGE_ONE, output_stage_scale(&stage, 30000));
+}
+
+void test_output_stage_should_keep_total_within_budget(void) {
+    output_stage_set_budget(&stage, 10000);
+
+    // Within the budget, untouched
+    TEST_ASSERT_EQUAL_UINT32(OUTPUT_STAGE_ONE, output_stage_scale(&stage, 10000));
+
+    // Over the budget, scaled to within 1 % below it
+    const uint32_t totals[] = {10001, 12345, 20000, 29997, 65535, 16 * 65535};
+    for (unsigned int i = 0; i < sizeof(totals) / sizeof(totals[0]); ++i) {
+        const uint32_t scale = output_stage_scale(&stage, totals[i]);
+        const uint64_t scaled = ((uint64_t)totals[i] * scale) >> 16;
+        TEST_ASSERT_TRUE(scaled <= 10000);
+        TEST_ASSERT_TRUE(scaled >= 9900);
+    }
+}
+
+void test_output_stage_budget_should_apply_after_brightness(void) {
+    output_stage_set_budget(&stage, 10000);
+    output_stage_set_brightness(&stage, OUTPUT_STAGE_ONE / 2);
+
+    // Half of 18000 fits the budget
+    TEST_ASSERT_EQUAL_UINT32(OUTPUT_STAGE_ONE / 2, output_stage_scale(&stage, 18000));
+
+    // Half of 40000 does not
+    const uint32_t scale = output_stage_scale(&stage, 40000);
+    TEST_ASSERT_TRUE(((40000ull * scale) >> 16) <= 10000);
+    TEST_ASSERT_TRUE(scale < OUTPUT_STAGE_ONE / 2);
+}
+
+void test_output_stage_should_handle_small_totals(void) {
+    output_stage_set_budget(&stage, 3);
+    for (uint32_t total = 4; total < 300; ++total) {
+        const uint32_t scale = output_stage_scale(&stage, total);
+        TEST_ASSERT_TRUE((((uint64_t)total * scale) >> 16) <= 3);
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_output_stage_should_pass_through_by_default);
+    RUN_TEST(test_output_stage_should_apply_master_brightness);
+    RUN_TEST(test_output_stage_should_keep_total_within_budget);
+    RUN_TEST(test_output_stage_budget_should_apply_after_brightness);
+    RUN_TEST(test_output_stage_should_handle_small_totals);
+    return UNITY_END();
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * This file contains unit tests for the profiling accumulators.
+ */
+
+#include "unity.h"
+#include "profile.h"
+
+void setUp(void) {
+    // This function is run before each test
+    profile_reset();
+}
+
+void tearDown(void) {
+    // This function is run after each test
+}
+
+void test_profile_should_accumulate_measurements(void) {
+    profile_record(PROFILE_HANDLE_COMMAND, 300);
+    profile_record(PROFILE_HANDLE_COMMAND, 100);
+    profile_record(PROFILE_HANDLE_COMMAND, 200);
+
+    const ProfileRegion *region = profile_region(PROFILE_HANDLE_COMMAND);
+    TEST_ASSERT_EQUAL_UINT32(3, region->count);
+    TEST_ASSERT_EQUAL_UINT32(100, region->min_cycles);
+    TEST_ASSERT_EQUAL_UINT32(300, region->max_cycles);
+    TEST_ASSERT_TRUE(region->total_cycles == 600);
+
+    // Other regions are untouched
+    TEST_ASSERT_EQUAL_UINT32(0, profile_region(PROFILE_UART_ISR)->count);
+}
+
+void test_profile_total_should_not_wrap(void) {
+    profile_record(PROFILE_PWM_ISR, UINT32_MAX);
+    profile_record(PROFILE_PWM_ISR, UINT32_MAX);
+    TEST_ASSERT_TRUE(profile_region(PROFILE_PWM_ISR)->total_cycles == 2ull * UINT32_MAX);
+}
+
+void test_profile_reset_should_clear_regions(void) {
+    profile_record(PROFILE_UART_ISR, 42);
+    profile_reset();
+
+    const ProfileRegion *region = profile_region(PROFILE_UART_ISR);
+    TEST_ASSERT_EQUAL_UINT32(0, region->count);
+    TEST_ASSERT_EQUAL_UINT32(0, region->max_cycles);
+    TEST_ASSERT_TRUE(region->total_cycles == 0);
+}
+
+void test_profile_region_should_reject_unknown_region(void) {
+    TEST_ASSERT_NULL(profile_region(PROFILE_REGIONS));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_profile_should_accumulate_measurements);
+    RUN_TEST(test_profile_total_should_not_wrap);
+    RUN_TEST(test_profile_reset_should_clear_regions);
+    RUN_TEST(test_profile_region_should_reject_unknown_region);
+    return UNITY_END();
+}
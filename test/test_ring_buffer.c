@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * This file contains unit tests for the byte ring buffer.
+ */
+
+#include "unity.h"
+#include "ring_buffer.h"
+
+static RingBuffer ring;
+
+void setUp(void) {
+    // This function is run before each test
+    ring_buffer_init(&ring);
+}
+
+void tearDown(void) {
+    // This function is run after each test
+}
+
+void test_ring_buffer_should_be_empty_after_init(void) {
+    unsigned char c;
+    TEST_ASSERT_EQUAL(0, ring_buffer_count(&ring));
+    TEST_ASSERT_EQUAL(-1, ring_buffer_get(&ring, &c));
+}
+
+void test_ring_buffer_should_return_bytes_in_order(void) {
+    unsigned char c;
+    TEST_ASSERT_EQUAL(0, ring_buffer_put(&ring, 'A'));
+    TEST_ASSERT_EQUAL(0, ring_buffer_put(&ring, 'B'));
+    TEST_ASSERT_EQUAL(2, ring_buffer_count(&ring));
+
+    TEST_ASSERT_EQUAL(0, ring_buffer_get(&ring, &c));
+    TEST_ASSERT_EQUAL('A', c);
+    TEST_ASSERT_EQUAL(0, ring_buffer_get(&ring, &c));
+    TEST_ASSERT_EQUAL('B', c);
+    TEST_ASSERT_EQUAL(-1, ring_buffer_get(&ring, &c));
+}
+
+void test_ring_buffer_should_reject_put_when_full_and_wrap(void) {
+    unsigned char c;
+    for (unsigned int i = 0; i < RING_BUFFER_SIZE; ++i) {
+        TEST_ASSERT_EQUAL(0, ring_buffer_put(&ring, (unsigned char)i));
+    }
+    TEST_ASSERT_EQUAL(-1, ring_buffer_put(&ring, 0xAA));
+
+    TEST_ASSERT_EQUAL(0, ring_buffer_get(&ring, &c));
+    TEST_ASSERT_EQUAL(0, c);
+    TEST_ASSERT_EQUAL(0, ring_buffer_put(&ring, 0xAA));
+    for (unsigned int i = 1; i < RING_BUFFER_SIZE; ++i) {
+        TEST_ASSERT_EQUAL(0, ring_buffer_get(&ring, &c));
+        TEST_ASSERT_EQUAL((unsigned char)i, c);
+    }
+    TEST_ASSERT_EQUAL(0, ring_buffer_get(&ring, &c));
+    TEST_ASSERT_EQUAL(0xAA, c);
+}
+
+void test_ring_buffer_should_write_and_peek_across_wrap(void) {
+    unsigned char data[RING_BUFFER_SIZE];
+    const unsigned char *run;
+    for (unsigned int i = 0; i < RING_BUFFER_SIZE; ++i) {
+        data[i] = (unsigned char)i;
+    }
+
+    TEST_ASSERT_EQUAL(RING_BUFFER_SIZE - 4, ring_buffer_write(&ring, data, RING_BUFFER_SIZE - 4));
+    ring_buffer_consume(&ring, RING_BUFFER_SIZE - 4);
+    TEST_ASSERT_EQUAL(10, ring_buffer_write(&ring, data, 10));
+
+    TEST_ASSERT_EQUAL(4, ring_buffer_peek(&ring, &run));
+    TEST_ASSERT_EQUAL(0, run[0]);
+    TEST_ASSERT_EQUAL(3, run[3]);
+    ring_buffer_consume(&ring, 4);
+
+    TEST_ASSERT_EQUAL(6, ring_buffer_peek(&ring, &run));
+    TEST_ASSERT_EQUAL(4, run[0]);
+    ring_buffer_consume(&ring, 6);
+    TEST_ASSERT_EQUAL(0, ring_buffer_peek(&ring, &run));
+}
+
+void test_ring_buffer_write_should_stop_when_full(void) {
+    unsigned char data[RING_BUFFER_SIZE] = {0};
+    TEST_ASSERT_EQUAL(RING_BUFFER_SIZE - 1, ring_buffer_write(&ring, data, RING_BUFFER_SIZE - 1));
+    TEST_ASSERT_EQUAL(1, ring_buffer_write(&ring, data, 5));
+    TEST_ASSERT_EQUAL(RING_BUFFER_SIZE, ring_buffer_count(&ring));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_ring_buffer_should_be_empty_after_init);
+    RUN_TEST(test_ring_buffer_should_return_bytes_in_order);
+    RUN_TEST(test_ring_buffer_should_reject_put_when_full_and_wrap);
+    RUN_TEST(test_ring_buffer_should_write_and_peek_across_wrap);
+    RUN_TEST(test_ring_buffer_write_should_stop_when_full);
+    return UNITY_END();
+}
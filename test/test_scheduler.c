@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * This file contains unit tests for the cooperative scheduler.
+ */
+
+#include "unity.h"
+#include "scheduler.h"
+
+static Scheduler scheduler;
+static uint32_t ticks;
+static uint32_t cycles;
+static uint32_t task_cycles;
+static uint32_t task_ticks;
+static int runs_a;
+static int runs_b;
+static int task_b;
+
+static uint32_t test_ticks(void) {
+    return ticks;
+}
+
+static uint32_t test_cycles(void) {
+    return cycles;
+}
+
+static void task_a_function(void) {
+    runs_a++;
+    cycles += task_cycles;
+    ticks += task_ticks;
+}
+
+static void task_b_function(void) {
+    runs_b++;
+    // Restart itself, as a retrying one-shot would
+    scheduler_start(&scheduler, task_b, 3);
+}
+
+void setUp(void) {
+    // This function is run before each test
+    ticks = 0xFFFFFFF0u;    // Close to wrap-around
+    cycles = 0;
+    task_cycles = 0;
+    task_ticks = 0;
+    runs_a = 0;
+    runs_b = 0;
+    scheduler_init(&scheduler, test_ticks, test_cycles);
+}
+
+void tearDown(void) {
+    // This function is run after each test
+}
+
+void test_scheduler_should_run_periodic_task_every_period(void) {
+    const int a = scheduler_add(&scheduler, task_a_function, 5, 5);
+    TEST_ASSERT_EQUAL_INT(0, a);
+    TEST_ASSERT_EQUAL_UINT(0, scheduler_run(&scheduler));
+
+    TEST_ASSERT_FALSE(scheduler_due(&scheduler));
+    TEST_ASSERT_EQUAL_INT(0, scheduler_start(&scheduler, a, 0));
+    TEST_ASSERT_TRUE(scheduler_due(&scheduler));
+    scheduler_run(&scheduler);
+    TEST_ASSERT_FALSE(scheduler_due(&scheduler));
+    ticks++;
+    for (int t = 1; t < 50; ++t) {
+        scheduler_run(&scheduler);
+        ticks++;
+    }
+    TEST_ASSERT_EQUAL_INT(10, runs_a);
+    TEST_ASSERT_EQUAL_UINT32(0, scheduler_task(&scheduler, a)->misses);
+}
+
+void test_scheduler_should_run_one_shot_task_once(void) {
+    task_b = scheduler_add(&scheduler, task_b_function, SCHEDULER_ONE_SHOT, 1);
+    const int a = scheduler_add(&scheduler, task_a_function, SCHEDULER_ONE_SHOT, 1);
+    scheduler_start(&scheduler, a, 2);
+
+    for (int t = 0; t < 10; ++t) {
+        scheduler_run(&scheduler);
+        ticks++;
+    }
+    TEST_ASSERT_EQUAL_INT(1, runs_a);
+    TEST_ASSERT_EQUAL_INT(0, runs_b);
+
+    // A one-shot task may start itself again
+    scheduler_start(&scheduler, task_b, 0);
+    for (int t = 0; t < 10; ++t) {
+        scheduler_run(&scheduler);
+        ticks++;
+    }
+    TEST_ASSERT_EQUAL_INT(4, runs_b);
+    scheduler_stop(&scheduler, task_b);
+    for (int t = 0; t < 10; ++t) {
+        scheduler_run(&scheduler);
+        ticks++;
+    }
+    TEST_ASSERT_EQUAL_INT(4, runs_b);
+}
+
+void test_scheduler_should_record_run_times(void) {
+    const int a = scheduler_add(&scheduler, task_a_function, 1, 1);
+    scheduler_start(&scheduler, a, 0);
+
+    task_cycles = 100;
+    scheduler_run(&scheduler);
+    ticks++;
+    task_cycles = 300;
+    scheduler_run(&scheduler);
+
+    const Task *task = scheduler_task(&scheduler, a);
+    TEST_ASSERT_EQUAL_UINT32(2, task->runs);
+    TEST_ASSERT_EQUAL_UINT32(300, task->max_cycles);
+    TEST_ASSERT_TRUE(task->total_cycles == 400);
+}
+
+void test_scheduler_should_count_misses_and_skip_releases(void) {
+    const int a = scheduler_add(&scheduler, task_a_function, 4, 2);
+    scheduler_start(&scheduler, a, 0);
+
+    // The first run overruns into the third period
+    task_ticks = 9;
+    scheduler_run(&scheduler);
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler_task(&scheduler, a)->misses);
+
+    // The releases already passed are skipped, the next run is on time
+    task_ticks = 0;
+    TEST_ASSERT_EQUAL_UINT(0, scheduler_run(&scheduler));
+    ticks += 3;
+    TEST_ASSERT_EQUAL_UINT(1, scheduler_run(&scheduler));
+    TEST_ASSERT_EQUAL_INT(2, runs_a);
+    TEST_ASSERT_EQUAL_UINT32(1, scheduler_task(&scheduler, a)->misses);
+}
+
+void test_scheduler_should_reject_full_table_and_unknown_tasks(void) {
+    for (int i = 0; i < SCHEDULER_MAX_TASKS; ++i) {
+        TEST_ASSERT_EQUAL_INT(i, scheduler_add(&scheduler, task_a_function, 1, 1));
+    }
+    TEST_ASSERT_EQUAL_INT(-1, scheduler_add(&scheduler, task_a_function, 1, 1));
+    TEST_ASSERT_EQUAL_INT(-1, scheduler_start(&scheduler, SCHEDULER_MAX_TASKS, 0));
+    TEST_ASSERT_EQUAL_INT(-1, scheduler_start(&scheduler, -1, 0));
+    TEST_ASSERT_NULL(scheduler_task(&scheduler, SCHEDULER_MAX_TASKS));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_scheduler_should_run_periodic_task_every_period);
+    RUN_TEST(test_scheduler_should_run_one_shot_task_once);
+    RUN_TEST(test_scheduler_should_record_run_times);
+    RUN_TEST(test_scheduler_should_count_misses_and_skip_releases);
+    RUN_TEST(test_scheduler_should_reject_full_table_and_unknown_tasks);
+    return UNITY_END();
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * This file contains unit tests for the keyframe sequencer.
+ */
+
+#include "unity.h"
+#include "sequencer.h"
+
+static Sequencer seq;
+static uint8_t out[3];
+static int outputs;
+
+static void mock_output(uint8_t r, uint8_t g, uint8_t b) {
+    out[0] = r;
+    out[1] = g;
+    out[2] = b;
+    outputs++;
+}
+
+static void tick(unsigned int ms) {
+    for (unsigned int i = 0; i < ms; ++i) {
+        sequencer_tick(&seq);
+    }
+}
+
+void setUp(void) {
+    // This function is run before each test
+    sequencer_init(&seq, mock_output);
+    outputs = 0;
+}
+
+void tearDown(void) {
+    // This function is run after each test
+}
+
+void test_sequencer_should_interpolate_linearly_between_keyframes(void) {
+    const uint8_t data[] = {
+        200, 0, 100, EASING_LINEAR, 100, 0,
+        0, 0, 0, EASING_LINEAR, 10, 0,
+    };
+    const uint8_t black[3] = {0, 0, 0};
+    TEST_ASSERT_EQUAL(2, sequencer_load(&seq, 0, data, sizeof(data)));
+    TEST_ASSERT_EQUAL(0, sequencer_play(&seq, false, black));
+
+    tick(50);
+    TEST_ASSERT_EQUAL_UINT8(100, out[0]);
+    TEST_ASSERT_EQUAL_UINT8(0, out[1]);
+    TEST_ASSERT_EQUAL_UINT8(50, out[2]);
+    tick(50);
+    TEST_ASSERT_EQUAL_UINT8(200, out[0]);
+    TEST_ASSERT_EQUAL_UINT8(100, out[2]);
+    TEST_ASSERT_TRUE(seq.playing);
+
+    tick(10);
+    TEST_ASSERT_EQUAL_UINT8(0, out[0]);
+    TEST_ASSERT_EQUAL_UINT8(0, out[2]);
+    TEST_ASSERT_FALSE(seq.playing);
+
+    // Stopped, no more output
+    const int before = outputs;
+    tick(10);
+    TEST_ASSERT_EQUAL(before, outputs);
+}
+
+void test_sequencer_should_loop_from_last_keyframe(void) {
+    const uint8_t data[] = {
+        255, 255, 255, EASING_STEP, 4, 0,
+        0, 0, 0, EASING_STEP, 4, 0,
+    };
+    const uint8_t black[3] = {0, 0, 0};
+    sequencer_load(&seq, 0, data, sizeof(data));
+    sequencer_play(&seq, true, black);
+
+    for (int round = 0; round < 3; ++round) {
+        tick(3);
+        TEST_ASSERT_EQUAL(2 * round, outputs);
+        tick(1);
+        TEST_ASSERT_EQUAL_UINT8(255, out[0]);
+        tick(4);
+        TEST_ASSERT_EQUAL_UINT8(0, out[0]);
+    }
+    TEST_ASSERT_TRUE(seq.playing);
+    sequencer_stop(&seq);
+    TEST_ASSERT_FALSE(seq.playing);
+}
+
+void test_sequencer_easing_should_start_slow_or_fast(void) {
+    const uint8_t ease_in[] = {255, 0, 0, EASING_IN, 100, 0};
+    const uint8_t ease_out[] = {255, 0, 0, EASING_OUT, 100, 0};
+    const uint8_t black[3] = {0, 0, 0};
+
+    sequencer_load(&seq, 0, ease_in, sizeof(ease_in));
+    sequencer_play(&seq, false, black);
+    tick(25);
+    TEST_ASSERT_TRUE(out[0] < 64);
+
+    sequencer_load(&seq, 0, ease_out, sizeof(ease_out));
+    sequencer_play(&seq, false, black);
+    tick(25);
+    TEST_ASSERT_TRUE(out[0] > 64);
+    tick(75);
+    TEST_ASSERT_EQUAL_UINT8(255, out[0]);
+}
+
+void test_sequencer_load_should_append_and_reject_invalid_uploads(void) {
+    uint8_t data[SEQUENCER_KEYFRAME_LENGTH * 2] = {0};
+    TEST_ASSERT_EQUAL(2, sequencer_load(&seq, 0, data, sizeof(data)));
+    TEST_ASSERT_EQUAL(4, sequencer_load(&seq, 2, data, sizeof(data)));
+    TEST_ASSERT_EQUAL(3, sequencer_load(&seq, 1, data, sizeof(data)));
+
+    // Gap, truncated keyframe, empty and overflowing uploads
+    TEST_ASSERT_EQUAL(-1, sequencer_load(&seq, 5, data, sizeof(data)));
+    TEST_ASSERT_EQUAL(-1, sequencer_load(&seq, 0, data, sizeof(data) - 1));
+    TEST_ASSERT_EQUAL(-1, sequencer_load(&seq, 0, data, 0));
+    for (unsigned int i = seq.count; i < SEQUENCER_MAX_KEYFRAMES; ++i) {
+        TEST_ASSERT_EQUAL((int)i + 1, sequencer_load(&seq, i, data, SEQUENCER_KEYFRAME_LENGTH));
+    }
+    TEST_ASSERT_EQUAL(-1, sequencer_load(&seq, SEQUENCER_MAX_KEYFRAMES - 1, data, sizeof(data)));
+}
+
+void test_sequencer_play_should_fail_without_keyframes(void) {
+    const uint8_t black[3] = {0, 0, 0};
+    TEST_ASSERT_EQUAL(-1, sequencer_play(&seq, false, black));
+    TEST_ASSERT_FALSE(seq.playing);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_sequencer_should_interpolate_linearly_between_keyframes);
+    RUN_TEST(test_sequencer_should_loop_from_last_keyframe);
+    RUN_TEST(test_sequencer_easing_should_start_slow_or_fast);
+    RUN_TEST(test_sequencer_load_should_append_and_reject_invalid_uploads);
+    RUN_TEST(test_sequencer_play_should_fail_without_keyframes);
+    return UNITY_END();
+}
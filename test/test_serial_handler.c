@@ -4,11 +4,13 @@
  * This file contains unit tests for the Serial Handler library.
  */
 
+#include <stdint.h>
 #include "unity.h"
 #include "serial_handler.h"
+#include "driverlib/sw_crc.h"
 
 static __uint8_t mock_r, mock_g, mock_b;
-static unsigned char mock_response[6];
+static unsigned char mock_response[32];
 static size_t mock_response_length;
 
 void mock_pwm_callback(__uint8_t r, __uint8_t g, __uint8_t b) {
@@ -21,12 +23,22 @@ void mock_send_callback(unsigned char c) {
     mock_response[mock_response_length++] = c;
 }
 
+static const __uint8_t *mock_frame;
+static size_t mock_frame_length;
+
+void mock_send_frame_callback(const __uint8_t *frame, size_t length) {
+    mock_frame = frame;
+    mock_frame_length = length;
+}
+
 void setUp(void) {
     // This function is run before each test
     mock_r = 0;
     mock_g = 0;
     mock_b = 0;
     mock_response_length = 0;
+    mock_frame = NULL;
+    mock_frame_length = 0;
 }
 
 void tearDown(void) {
@@ -103,7 +115,7 @@ void test_handle_command_should_set_led_color(void) {
     init_serial_port_handler(&handler, mock_pwm_callback, mock_send_callback);
 
     unsigned char command[] = {MSG_TYPE_REQUEST, OPCODE_SET_LED_COLOR, 10, 20, 30};
-    handle_command(command, &handler);
+    handle_command(command, sizeof(command), &handler);
 
     TEST_ASSERT_EQUAL(10, mock_r);
     TEST_ASSERT_EQUAL(20, mock_g);
@@ -124,7 +136,7 @@ void test_handle_command_should_get_led_color(void) {
     handler.b = 30;
 
     unsigned char command[] = {MSG_TYPE_REQUEST, OPCODE_GET_LED_COLOR};
-    handle_command(command, &handler);
+    handle_command(command, sizeof(command), &handler);
 
     TEST_ASSERT_EQUAL(6, mock_response_length);
     TEST_ASSERT_EQUAL(START_CHAR, mock_response[0]);
@@ -135,6 +147,343 @@ void test_handle_command_should_get_led_color(void) {
     TEST_ASSERT_EQUAL(END_CHAR, mock_response[5]);
 }
 
+void test_serial_receive_bytes_should_handle_complete_frame(void) {
+    SerialPortHandler handler;
+    init_serial_port_handler(&handler, mock_pwm_callback, mock_send_callback);
+
+    const __uint8_t frame[] = {START_CHAR, MSG_TYPE_REQUEST, OPCODE_SET_LED_COLOR, 10, ESCAPE_CHAR, END_CHAR, 30, END_CHAR};
+    serial_receive_bytes(&handler, frame, sizeof(frame));
+
+    TEST_ASSERT_EQUAL(10, mock_r);
+    TEST_ASSERT_EQUAL(END_CHAR, mock_g);
+    TEST_ASSERT_EQUAL(30, mock_b);
+    TEST_ASSERT_EQUAL(0, handler.buffer_index);
+    TEST_ASSERT_FALSE(handler.started);
+}
+
+void test_serial_receive_bytes_should_keep_state_across_spans(void) {
+    SerialPortHandler handler;
+    init_serial_port_handler(&handler, mock_pwm_callback, mock_send_callback);
+
+    const __uint8_t first[] = {0x55, START_CHAR, MSG_TYPE_REQUEST, OPCODE_SET_LED_COLOR, ESCAPE_CHAR};
+    const __uint8_t second[] = {START_CHAR, 20, 30, END_CHAR};
+    serial_receive_bytes(&handler, first, sizeof(first));
+    TEST_ASSERT_TRUE(handler.started);
+    TEST_ASSERT_TRUE(handler.escape_flag);
+    TEST_ASSERT_EQUAL(2, handler.buffer_index);
+
+    serial_receive_bytes(&handler, second, sizeof(second));
+    TEST_ASSERT_EQUAL(START_CHAR, mock_r);
+    TEST_ASSERT_EQUAL(20, mock_g);
+    TEST_ASSERT_EQUAL(30, mock_b);
+    TEST_ASSERT_EQUAL(4, mock_response_length);
+    TEST_ASSERT_FALSE(handler.started);
+}
+
+static size_t mock_command_handler(SerialPortHandler *handler, const __uint8_t *payload, size_t payload_length, __uint8_t *response) {
+    (void)handler;
+    response[0] = (__uint8_t)payload_length;
+    response[1] = payload[0];
+    return 2;
+}
+
+void test_handle_command_should_dispatch_registered_command(void) {
+    SerialPortHandler handler;
+    init_serial_port_handler(&handler, mock_pwm_callback, mock_send_callback);
+    TEST_ASSERT_EQUAL(0, serial_register_command(&handler, 0x10, mock_command_handler, PAYLOAD_LENGTH_VARIABLE, 2));
+
+    unsigned char command[] = {MSG_TYPE_REQUEST, 0x10, 42, 43};
+    handle_command(command, sizeof(command), &handler);
+    TEST_ASSERT_EQUAL(1, handler.commands_handled);
+
+    TEST_ASSERT_EQUAL(5, mock_response_length);
+    TEST_ASSERT_EQUAL(2, mock_response[2]);
+    TEST_ASSERT_EQUAL(42, mock_response[3]);
+}
+
+void test_serial_receive_should_drop_over_length_frame_without_crc(void) {
+    SerialPortHandler handler;
+    __uint8_t frame[BUFFER_SIZE + 8];
+    size_t n = 0;
+    init_serial_port_handler(&handler, mock_pwm_callback, mock_send_callback);
+    TEST_ASSERT_EQUAL(0, serial_register_command(&handler, 0x10, mock_command_handler, PAYLOAD_LENGTH_VARIABLE, 2));
+
+    frame[n++] = START_CHAR;
+    frame[n++] = MSG_TYPE_REQUEST;
+    frame[n++] = 0x10;
+    while (n < sizeof(frame) - 1) {
+        frame[n++] = 1;
+    }
+    frame[n++] = END_CHAR;
+
+    // Byte by byte and as one span
+    for (size_t i = 0; i < n; ++i) {
+        serial_receive_char(&handler, frame[i]);
+    }
+    serial_receive_bytes(&handler, frame, n);
+    TEST_ASSERT_EQUAL(0, handler.commands_handled);
+    TEST_ASSERT_EQUAL(0, handler.frames_valid);
+    TEST_ASSERT_EQUAL(0, mock_response_length);
+    TEST_ASSERT_EQUAL(2, handler.overflow_errors);
+
+    // The next frame is received normally
+    const __uint8_t next[] = {START_CHAR, MSG_TYPE_REQUEST, 0x10, 42, END_CHAR};
+    serial_receive_bytes(&handler, next, sizeof(next));
+    TEST_ASSERT_EQUAL(1, handler.commands_handled);
+    TEST_ASSERT_EQUAL(1, handler.frames_valid);
+    TEST_ASSERT_EQUAL(2, handler.overflow_errors);
+}
+
+void test_serial_register_command_should_reject_out_of_range_opcode(void) {
+    SerialPortHandler handler;
+    init_serial_port_handler(&handler, mock_pwm_callback, mock_send_callback);
+    TEST_ASSERT_EQUAL(-1, serial_register_command(&handler, COMMAND_TABLE_SIZE, mock_command_handler, 0, 2));
+    TEST_ASSERT_EQUAL(-1, serial_register_command(&handler, 0x10, mock_command_handler, 0, MAX_RESPONSE_LENGTH + 1));
+}
+
+void test_handle_command_should_ignore_unknown_opcode(void) {
+    SerialPortHandler handler;
+    init_serial_port_handler(&handler, mock_pwm_callback, mock_send_callback);
+
+    unsigned char command[] = {MSG_TYPE_REQUEST, 0x11, 1, 2, 3};
+    handle_command(command, sizeof(command), &handler);
+    TEST_ASSERT_EQUAL(0, mock_response_length);
+    TEST_ASSERT_EQUAL(0, handler.commands_handled);
+}
+
+void test_handle_command_should_ignore_wrong_payload_length(void) {
+    SerialPortHandler handler;
+    init_serial_port_handler(&handler, mock_pwm_callback, mock_send_callback);
+
+    unsigned char command[] = {MSG_TYPE_REQUEST, OPCODE_SET_LED_COLOR, 10, 20};
+    handle_command(command, sizeof(command), &handler);
+    TEST_ASSERT_EQUAL(0, mock_r);
+    TEST_ASSERT_EQUAL(0, mock_response_length);
+}
+
+static size_t put_escaped(__uint8_t *frame, size_t n, __uint8_t c) {
+    if (c == START_CHAR || c == END_CHAR || c == ESCAPE_CHAR) {
+        frame[n++] = ESCAPE_CHAR;
+    }
+    frame[n++] = c;
+    return n;
+}
+
+static size_t build_crc_frame(__uint8_t *frame, const __uint8_t *message, size_t length) {
+    const __uint16_t crc = Crc16(0, message, (uint32_t)length);
+    size_t n = 0;
+    frame[n++] = START_CHAR;
+    for (size_t i = 0; i < length; ++i) {
+        n = put_escaped(frame, n, message[i]);
+    }
+    n = put_escaped(frame, n, (__uint8_t)(crc & 0xFF));
+    n = put_escaped(frame, n, (__uint8_t)(crc >> 8));
+    frame[n++] = END_CHAR;
+    return n;
+}
+
+void test_serial_receive_bytes_should_accept_frame_with_valid_crc(void) {
+    SerialPortHandler handler;
+    __uint8_t frame[16];
+    const __uint8_t message[] = {MSG_TYPE_REQUEST, OPCODE_SET_LED_COLOR, 10, START_CHAR, 30};
+    init_serial_port_handler(&handler, mock_pwm_callback, mock_send_callback);
+    serial_enable_crc(&handler, 1);
+
+    const size_t n = build_crc_frame(frame, message, sizeof(message));
+    serial_receive_bytes(&handler, frame, n);
+
+    TEST_ASSERT_EQUAL(10, mock_r);
+    TEST_ASSERT_EQUAL(START_CHAR, mock_g);
+    TEST_ASSERT_EQUAL(30, mock_b);
+    TEST_ASSERT_EQUAL(0, handler.crc_errors);
+}
+
+void test_serial_receive_char_should_reject_frame_with_bad_crc(void) {
+    SerialPortHandler handler;
+    __uint8_t frame[16];
+    const __uint8_t message[] = {MSG_TYPE_REQUEST, OPCODE_SET_LED_COLOR, 10, 20, 30};
+    init_serial_port_handler(&handler, mock_pwm_callback, mock_send_callback);
+    serial_enable_crc(&handler, 1);
+
+    const size_t n = build_crc_frame(frame, message, sizeof(message));
+    frame[3] ^= 0x01;
+    for (size_t i = 0; i < n; ++i) {
+        serial_receive_char(&handler, frame[i]);
+    }
+
+    TEST_ASSERT_EQUAL(0, mock_r);
+    TEST_ASSERT_EQUAL(0, mock_response_length);
+    TEST_ASSERT_EQUAL(1, handler.crc_errors);
+}
+
+void test_serial_receive_should_accept_max_length_frame_with_crc(void) {
+    SerialPortHandler handler;
+    __uint8_t message[BUFFER_SIZE - 1 - CRC_LENGTH];
+    __uint8_t frame[2 * BUFFER_SIZE + 2];
+    init_serial_port_handler(&handler, mock_pwm_callback, mock_send_callback);
+    TEST_ASSERT_EQUAL(0, serial_register_command(&handler, 0x10, mock_command_handler, PAYLOAD_LENGTH_VARIABLE, 2));
+    serial_enable_crc(&handler, 1);
+
+    // The frame fills the buffer exactly
+    message[0] = MSG_TYPE_REQUEST;
+    message[1] = 0x10;
+    for (size_t i = 2; i < sizeof(message); ++i) {
+        message[i] = (__uint8_t)i;
+    }
+    const size_t n = build_crc_frame(frame, message, sizeof(message));
+
+    // Byte by byte and as one span
+    for (size_t i = 0; i < n; ++i) {
+        serial_receive_char(&handler, frame[i]);
+    }
+    serial_receive_bytes(&handler, frame, n);
+    TEST_ASSERT_EQUAL(2, handler.commands_handled);
+    TEST_ASSERT_EQUAL(0, handler.crc_errors);
+    TEST_ASSERT_EQUAL(0, handler.overflow_errors);
+}
+
+void test_serial_receive_should_count_only_valid_frames(void) {
+    SerialPortHandler handler;
+    __uint8_t frame[16];
+    init_serial_port_handler(&handler, mock_pwm_callback, mock_send_callback);
+
+    // Without CRC, a frame must name a registered command with its payload length
+    const __uint8_t noise[] = {START_CHAR, 0x55, 0x66, END_CHAR};
+    const __uint8_t short_payload[] = {START_CHAR, MSG_TYPE_REQUEST, OPCODE_SET_LED_COLOR, 1, END_CHAR};
+    const __uint8_t command[] = {START_CHAR, MSG_TYPE_REQUEST, OPCODE_SET_LED_COLOR, 1, 2, 3, END_CHAR};
+    serial_receive_bytes(&handler, noise, sizeof(noise));
+    serial_receive_bytes(&handler, short_payload, sizeof(short_payload));
+    TEST_ASSERT_EQUAL(0, handler.frames_valid);
+    serial_receive_bytes(&handler, command, sizeof(command));
+    TEST_ASSERT_EQUAL(1, handler.frames_valid);
+
+    // With CRC, any frame that passes it counts
+    const __uint8_t message[] = {0x55, 0x66};
+    serial_enable_crc(&handler, 1);
+    const size_t n = build_crc_frame(frame, message, sizeof(message));
+    serial_receive_bytes(&handler, frame, n);
+    TEST_ASSERT_EQUAL(2, handler.frames_valid);
+}
+
+void test_send_serial_response_should_escape_and_append_crc(void) {
+    SerialPortHandler handler;
+    const __uint8_t response[] = {START_CHAR};
+    const __uint8_t message[] = {MSG_TYPE_RESPONSE, START_CHAR};
+    const __uint16_t crc = Crc16(0, message, sizeof(message));
+    init_serial_port_handler(&handler, mock_pwm_callback, mock_send_callback);
+    serial_enable_crc(&handler, 1);
+
+    send_serial_response(&handler, response, sizeof(response));
+
+    TEST_ASSERT_EQUAL(START_CHAR, mock_response[0]);
+    TEST_ASSERT_EQUAL(MSG_TYPE_RESPONSE, mock_response[1]);
+    TEST_ASSERT_EQUAL(ESCAPE_CHAR, mock_response[2]);
+    TEST_ASSERT_EQUAL(START_CHAR, mock_response[3]);
+
+    // Decode the trailer and check it against the expected CRC
+    __uint8_t trailer[CRC_LENGTH];
+    size_t t = 0;
+    for (size_t i = 4; i < mock_response_length - 1; ++i) {
+        if (mock_response[i] == ESCAPE_CHAR) {
+            ++i;
+        }
+        trailer[t++] = mock_response[i];
+    }
+    TEST_ASSERT_EQUAL(CRC_LENGTH, t);
+    TEST_ASSERT_EQUAL(crc, trailer[0] | (trailer[1] << 8));
+    TEST_ASSERT_EQUAL(END_CHAR, mock_response[mock_response_length - 1]);
+}
+
+void test_handle_command_should_execute_batch(void) {
+    SerialPortHandler handler;
+    init_serial_port_handler(&handler, mock_pwm_callback, mock_send_callback);
+
+    unsigned char command[] = {MSG_TYPE_REQUEST, OPCODE_BATCH,
+                               OPCODE_SET_LED_COLOR, 1, 2, 3,
+                               OPCODE_SET_LED_COLOR, 4, 5, 6,
+                               OPCODE_GET_LED_COLOR};
+    handle_command(command, sizeof(command), &handler);
+
+    TEST_ASSERT_EQUAL(4, mock_r);
+    TEST_ASSERT_EQUAL(5, mock_g);
+    TEST_ASSERT_EQUAL(6, mock_b);
+    TEST_ASSERT_EQUAL(9, mock_response_length);
+    TEST_ASSERT_EQUAL(MSG_TYPE_RESPONSE, mock_response[1]);
+    TEST_ASSERT_EQUAL(3, mock_response[2]);
+    TEST_ASSERT_EQUAL(1, mock_response[3]);
+    TEST_ASSERT_EQUAL(1, mock_response[4]);
+    TEST_ASSERT_EQUAL(4, mock_response[5]);
+    TEST_ASSERT_EQUAL(5, mock_response[6]);
+    TEST_ASSERT_EQUAL(6, mock_response[7]);
+    TEST_ASSERT_EQUAL(END_CHAR, mock_response[8]);
+}
+
+void test_handle_command_should_stop_batch_at_invalid_subcommand(void) {
+    SerialPortHandler handler;
+    init_serial_port_handler(&handler, mock_pwm_callback, mock_send_callback);
+
+    unsigned char command[] = {MSG_TYPE_REQUEST, OPCODE_BATCH,
+                               OPCODE_SET_LED_COLOR, 1, 2, 3,
+                               OPCODE_BATCH, OPCODE_SET_LED_COLOR, 4, 5, 6};
+    handle_command(command, sizeof(command), &handler);
+
+    TEST_ASSERT_EQUAL(1, mock_r);
+    TEST_ASSERT_EQUAL(5, mock_response_length);
+    TEST_ASSERT_EQUAL(1, mock_response[2]);
+}
+
+void test_handle_command_should_echo_sequence_number(void) {
+    SerialPortHandler handler;
+    init_serial_port_handler(&handler, mock_pwm_callback, mock_send_callback);
+    handler.r = 10;
+    handler.g = 20;
+    handler.b = 30;
+
+    unsigned char command[] = {MSG_TYPE_REQUEST_SEQ, 0x42, OPCODE_GET_LED_COLOR};
+    handle_command(command, sizeof(command), &handler);
+
+    TEST_ASSERT_EQUAL(7, mock_response_length);
+    TEST_ASSERT_EQUAL(MSG_TYPE_RESPONSE_SEQ, mock_response[1]);
+    TEST_ASSERT_EQUAL(0x42, mock_response[2]);
+    TEST_ASSERT_EQUAL(10, mock_response[3]);
+    TEST_ASSERT_EQUAL(30, mock_response[5]);
+    TEST_ASSERT_FALSE(handler.sequence_valid);
+}
+
+void test_handle_command_should_escape_sequence_number(void) {
+    SerialPortHandler handler;
+    init_serial_port_handler(&handler, mock_pwm_callback, mock_send_callback);
+
+    unsigned char command[] = {MSG_TYPE_REQUEST_SEQ, END_CHAR, OPCODE_SET_LED_COLOR, 1, 2, 3};
+    handle_command(command, sizeof(command), &handler);
+
+    TEST_ASSERT_EQUAL(1, mock_r);
+    TEST_ASSERT_EQUAL(6, mock_response_length);
+    TEST_ASSERT_EQUAL(MSG_TYPE_RESPONSE_SEQ, mock_response[1]);
+    TEST_ASSERT_EQUAL(ESCAPE_CHAR, mock_response[2]);
+    TEST_ASSERT_EQUAL(END_CHAR, mock_response[3]);
+    TEST_ASSERT_EQUAL(1, mock_response[4]);
+}
+
+void test_send_serial_response_should_send_whole_frame(void) {
+    SerialPortHandler handler;
+    const __uint8_t response[] = {7, ESCAPE_CHAR};
+    init_serial_port_handler(&handler, mock_pwm_callback, mock_send_callback);
+    serial_set_frame_sender(&handler, mock_send_frame_callback);
+
+    send_serial_response(&handler, response, sizeof(response));
+
+    TEST_ASSERT_EQUAL(0, mock_response_length);
+    TEST_ASSERT_NOT_NULL(mock_frame);
+    TEST_ASSERT_EQUAL(6, mock_frame_length);
+    TEST_ASSERT_EQUAL(START_CHAR, mock_frame[0]);
+    TEST_ASSERT_EQUAL(MSG_TYPE_RESPONSE, mock_frame[1]);
+    TEST_ASSERT_EQUAL(7, mock_frame[2]);
+    TEST_ASSERT_EQUAL(ESCAPE_CHAR, mock_frame[3]);
+    TEST_ASSERT_EQUAL(ESCAPE_CHAR, mock_frame[4]);
+    TEST_ASSERT_EQUAL(END_CHAR, mock_frame[5]);
+}
+
 int main(void) {
     UNITY_BEGIN();
     RUN_TEST(test_serial_receive_char_should_start_on_start_char);
@@ -145,5 +494,22 @@ int main(void) {
     RUN_TEST(test_serial_receive_char_should_handle_end_char);
     RUN_TEST(test_handle_command_should_set_led_color);
     RUN_TEST(test_handle_command_should_get_led_color);
+    RUN_TEST(test_serial_receive_bytes_should_handle_complete_frame);
+    RUN_TEST(test_serial_receive_bytes_should_keep_state_across_spans);
+    RUN_TEST(test_handle_command_should_dispatch_registered_command);
+    RUN_TEST(test_serial_register_command_should_reject_out_of_range_opcode);
+    RUN_TEST(test_handle_command_should_ignore_unknown_opcode);
+    RUN_TEST(test_handle_command_should_ignore_wrong_payload_length);
+    RUN_TEST(test_serial_receive_bytes_should_accept_frame_with_valid_crc);
+    RUN_TEST(test_serial_receive_char_should_reject_frame_with_bad_crc);
+    RUN_TEST(test_serial_receive_should_accept_max_length_frame_with_crc);
+    RUN_TEST(test_serial_receive_should_count_only_valid_frames);
+    RUN_TEST(test_send_serial_response_should_escape_and_append_crc);
+    RUN_TEST(test_handle_command_should_execute_batch);
+    RUN_TEST(test_handle_command_should_stop_batch_at_invalid_subcommand);
+    RUN_TEST(test_handle_command_should_echo_sequence_number);
+    RUN_TEST(test_handle_command_should_escape_sequence_number);
+    RUN_TEST(test_send_serial_response_should_send_whole_frame);
+    RUN_TEST(test_serial_receive_should_drop_over_length_frame_without_crc);
     return UNITY_END();
 }
\ No newline at end of file
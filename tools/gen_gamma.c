@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2025 Tuomo Kohtamäki
+ * 
+ * Build-time generator for the gamma correction table. Run on the host by
+ * the Makefile; prints a C source file mapping 8-bit color values to PWM
+ * pulse widths.
+ * 
+ * Usage: gen_gamma <pwm period> <gamma>
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <pwm period> <gamma>\n", argv[0]);
+        return 1;
+    }
+    const long period = strtol(argv[1], NULL, 10);
+    const double gamma = strtod(argv[2], NULL);
+    if (period < 2 || period > 65535 || gamma <= 0.0) {
+        fprintf(stderr, "Invalid period or gamma\n");
+        return 1;
+    }
+
+    // The full period is not a valid pulse width, so the top value is one less
+    const double max = (double)(period - 1);
+
+    printf("/* Generated by tools/gen_gamma.c, do not edit. */\n\n");
+    printf("#include \"gamma_table.h\"\n\n");
+    printf("// PWM period %ld, gamma %.2f\n", period, gamma);
+    printf("const uint16_t gamma_table[GAMMA_TABLE_SIZE] = {");
+    for (int i = 0; i < 256; ++i) {
+        const long width = lround(max * pow(i / 255.0, gamma));
+        printf("%s%5ld,", (i % 8 == 0) ? "\n    " : " ", width);
+    }
+    printf("\n};\n");
+    return 0;
+}